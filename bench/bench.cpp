@@ -0,0 +1,404 @@
+#include "bench.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <new>
+#include <ftw.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<long long> allocations(0);
+
+void* allocate(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = malloc(size ? size : 1);
+    if (!memory) throw std::bad_alloc();
+    return memory;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    free(memory);
+}
+
+namespace bench {
+
+namespace {
+
+std::vector<Benchmark*>& registry() {
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
+
+double cpuNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct Result {
+    std::string name;
+    long iterations;
+    double realNs;  // per iteration
+    double cpuNs;
+    double bytesPerSecond;
+    double itemsPerSecond;
+    std::map<std::string, double> counters;
+    std::string label;
+};
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            escaped += buffer;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// Grow the iteration count until a run takes at least minTime
+Result measure(Benchmark* benchmark, const std::string& name, long arg, double minTime) {
+    long iterations = 1;
+    for (;;) {
+        State state(iterations, arg);
+        benchmark->getFunction()(state);
+
+        double seconds = state.getRealSeconds();
+        if (seconds >= minTime || iterations >= 1000000000L) {
+            Result result;
+            result.name = name;
+            result.iterations = iterations;
+            result.realNs = seconds * 1e9 / iterations;
+            result.cpuNs = state.getCpuSeconds() * 1e9 / iterations;
+            result.bytesPerSecond = seconds > 0 ? state.getBytesProcessed() / seconds : 0;
+            result.itemsPerSecond = seconds > 0 ? state.getItemsProcessed() / seconds : 0;
+            result.counters = state.getCounters();
+            result.label = state.getLabel();
+            return result;
+        }
+
+        // Aim a little past minTime, but never more than 10x at once
+        double scale = seconds > 0 ? minTime * 1.4 / seconds : 10;
+        if (scale > 10) scale = 10;
+        long next = static_cast<long>(iterations * scale);
+        iterations = next > iterations ? next : iterations + 1;
+    }
+}
+
+std::string formatRate(double perSecond, const char* unit) {
+    static const char* prefixes[] = { "", "k", "M", "G", "T" };
+    int prefix = 0;
+    while (perSecond >= 1000 && prefix < 4) {
+        perSecond /= 1000;
+        ++prefix;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3g%s%s/s", perSecond, prefixes[prefix], unit);
+    return buffer;
+}
+
+void printConsole(const Result& result) {
+    printf("%-40s %12.1f ns %12.1f ns %12ld", result.name.c_str(), result.realNs, result.cpuNs,
+           result.iterations);
+    if (result.bytesPerSecond > 0) {
+        printf(" %s", formatRate(result.bytesPerSecond, "B").c_str());
+    }
+    if (result.itemsPerSecond > 0) {
+        printf(" %s", formatRate(result.itemsPerSecond, " items").c_str());
+    }
+    for (std::map<std::string, double>::const_iterator it = result.counters.begin();
+         it != result.counters.end(); ++it) {
+        printf(" %s=%g", it->first.c_str(), it->second);
+    }
+    if (!result.label.empty()) {
+        printf(" %s", result.label.c_str());
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results, const char* executable) {
+    char date[64];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"executable\": \"" << jsonEscape(executable) << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef DEBUG
+        << "    \"library_build_type\": \"debug\"\n"
+#else
+        << "    \"library_build_type\": \"release\"\n"
+#endif
+        << "  },\n"
+        << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\n"
+            << "      \"name\": \"" << jsonEscape(result.name) << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": " << result.realNs << ",\n"
+            << "      \"cpu_time\": " << result.cpuNs << ",\n"
+            << "      \"time_unit\": \"ns\"";
+        if (result.bytesPerSecond > 0) {
+            out << ",\n      \"bytes_per_second\": " << result.bytesPerSecond;
+        }
+        if (result.itemsPerSecond > 0) {
+            out << ",\n      \"items_per_second\": " << result.itemsPerSecond;
+        }
+        for (std::map<std::string, double>::const_iterator it = result.counters.begin();
+             it != result.counters.end(); ++it) {
+            out << ",\n      \"" << jsonEscape(it->first) << "\": " << it->second;
+        }
+        if (!result.label.empty()) {
+            out << ",\n      \"label\": \"" << jsonEscape(result.label) << "\"";
+        }
+        out << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void showUsage() {
+    printf("Usage: cvim_bench [options]\n"
+           "\n"
+           "Options:\n"
+           "  --filter=REGEX     Run only the benchmarks whose name matches\n"
+           "  --min-time=SECS    Minimum time per benchmark (default 0.5)\n"
+           "  --format=json      Print JSON instead of a table\n"
+           "  --out=FILE         Also write the JSON results to FILE\n"
+           "  --list             List the benchmarks and exit\n");
+}
+
+int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+bool optionValue(const std::string& arg, const char* option, std::string& value) {
+    size_t length = strlen(option);
+    if (arg.compare(0, length, option) != 0 || arg.size() <= length || arg[length] != '=') {
+        return false;
+    }
+    value = arg.substr(length + 1);
+    return true;
+}
+
+} // namespace
+
+State::State(long iterations, long range)
+    : iterations_(iterations), done_(0), range_(range), running_(false),
+      cpuStart_(0), realSeconds_(0), cpuSeconds_(0), bytes_(0), items_(0) {}
+
+void State::start() {
+    running_ = true;
+    realStart_ = std::chrono::steady_clock::now();
+    cpuStart_ = cpuNow();
+}
+
+void State::stop() {
+    if (!running_) return;
+    running_ = false;
+    realSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart_).count();
+    cpuSeconds_ += cpuNow() - cpuStart_;
+}
+
+void State::pauseTiming() {
+    stop();
+}
+
+void State::resumeTiming() {
+    start();
+}
+
+Benchmark::Benchmark(const std::string& name, Function function)
+    : name_(name), function_(function) {}
+
+Benchmark* Benchmark::arg(long value) {
+    args_.push_back(value);
+    return this;
+}
+
+Benchmark* Benchmark::range(long low, long high, long multiplier) {
+    for (long value = low; value < high; value *= multiplier) {
+        args_.push_back(value);
+    }
+    args_.push_back(high);
+    return this;
+}
+
+Benchmark* registerBenchmark(const char* name, Function function) {
+    Benchmark* benchmark = new Benchmark(name, function);
+    registry().push_back(benchmark);
+    return benchmark;
+}
+
+long long allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+TempDir::TempDir() {
+    const char* base = getenv("TMPDIR");
+    std::string pattern = std::string(base ? base : "/tmp") + "/cvim_bench.XXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+    if (mkdtemp(&buffer[0])) {
+        path_ = &buffer[0];
+    }
+}
+
+TempDir::~TempDir() {
+    if (!path_.empty()) {
+        nftw(path_.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+int runBenchmarks(int argc, char** argv) {
+    std::string filter;
+    std::string outPath;
+    std::string value;
+    double minTime = 0.5;
+    bool json = false;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (optionValue(arg, "--filter", value) || optionValue(arg, "--benchmark_filter", value)) {
+            filter = value;
+        } else if (optionValue(arg, "--min-time", value)) {
+            minTime = atof(value.c_str());
+        } else if (optionValue(arg, "--format", value)) {
+            if (value != "json" && value != "console") {
+                fprintf(stderr, "cvim_bench: unknown format: %s\n", value.c_str());
+                return 1;
+            }
+            json = value == "json";
+        } else if (optionValue(arg, "--out", value)) {
+            outPath = value;
+        } else if (arg == "--list") {
+            list = true;
+        } else if (arg == "--help" || arg == "-h") {
+            showUsage();
+            return 0;
+        } else {
+            fprintf(stderr, "cvim_bench: unknown option: %s\n", arg.c_str());
+            showUsage();
+            return 1;
+        }
+    }
+
+    std::regex pattern;
+    try {
+        pattern.assign(filter.empty() ? "." : filter);
+    } catch (const std::regex_error&) {
+        fprintf(stderr, "cvim_bench: invalid filter: %s\n", filter.c_str());
+        return 1;
+    }
+
+    // Expand the arguments into the runs to make
+    std::vector<std::pair<Benchmark*, long> > runs;
+    std::vector<std::string> names;
+    const std::vector<Benchmark*>& benchmarks = registry();
+    for (size_t i = 0; i < benchmarks.size(); ++i) {
+        std::vector<long> args = benchmarks[i]->getArgs();
+        bool named = !args.empty();
+        if (!named) args.push_back(0);
+        for (size_t j = 0; j < args.size(); ++j) {
+            std::stringstream name;
+            name << benchmarks[i]->getName();
+            if (named) name << "/" << args[j];
+            if (!std::regex_search(name.str(), pattern)) continue;
+            runs.push_back(std::make_pair(benchmarks[i], args[j]));
+            names.push_back(name.str());
+        }
+    }
+
+    if (list) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            printf("%s\n", names[i].c_str());
+        }
+        return 0;
+    }
+
+    if (!json) {
+        printf("%-40s %15s %15s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+        printf("%s\n", std::string(85, '-').c_str());
+    }
+
+    std::vector<Result> results;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        results.push_back(measure(runs[i].first, names[i], runs[i].second, minTime));
+        if (!json) {
+            printConsole(results.back());
+        }
+    }
+
+    if (json) {
+        writeJson(std::cout, results, argv[0]);
+    }
+    if (!outPath.empty()) {
+        std::ofstream out(outPath.c_str());
+        writeJson(out, results, argv[0]);
+        if (!out) {
+            fprintf(stderr, "cvim_bench: cannot write %s\n", outPath.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace bench
+
+int main(int argc, char** argv) {
+    return bench::runBenchmarks(argc, argv);
+}
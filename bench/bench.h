@@ -0,0 +1,136 @@
+// Minimal benchmark harness in the style of Google Benchmark, so the suite
+// builds with nothing but the editor sources.
+//
+//   static void BM_Thing(bench::State& state) {
+//       Setup setup(state.range());
+//       while (state.keepRunning()) {
+//           doThing(setup);
+//       }
+//       state.setItemsProcessed(state.iterations());
+//   }
+//   BENCHMARK(BM_Thing)->arg(64)->arg(4096);
+//
+// Every benchmark runs until it has taken at least --min-time seconds.
+// Results go to stdout as a table, or as JSON with --format=json (the
+// same layout as Google Benchmark's, so its compare tools work on it).
+
+#ifndef CVIM_BENCH_H
+#define CVIM_BENCH_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+class State {
+public:
+    State(long iterations, long range);
+
+    // Loop condition; timing starts with the first call and stops when it
+    // returns false
+    bool keepRunning() {
+        if (done_ < iterations_) {
+            if (done_++ == 0) start();
+            return true;
+        }
+        stop();
+        return false;
+    }
+
+    long iterations() const { return iterations_; }
+    // The argument given with ->arg(), or 0
+    long range() const { return range_; }
+
+    // Exclude setup or cleanup inside the loop from the measurement
+    void pauseTiming();
+    void resumeTiming();
+
+    // Throughput: reported per second of real time
+    void setBytesProcessed(long long bytes) { bytes_ = bytes; }
+    void setItemsProcessed(long long items) { items_ = items; }
+    // Reported as is
+    void setCounter(const std::string& name, double value) { counters_[name] = value; }
+    void setLabel(const std::string& label) { label_ = label; }
+
+    double getRealSeconds() const { return realSeconds_; }
+    double getCpuSeconds() const { return cpuSeconds_; }
+    long long getBytesProcessed() const { return bytes_; }
+    long long getItemsProcessed() const { return items_; }
+    const std::map<std::string, double>& getCounters() const { return counters_; }
+    const std::string& getLabel() const { return label_; }
+
+private:
+    void start();
+    void stop();
+
+    long iterations_;
+    long done_;
+    long range_;
+    bool running_;
+    std::chrono::steady_clock::time_point realStart_;
+    double cpuStart_;
+    double realSeconds_;
+    double cpuSeconds_;
+    long long bytes_;
+    long long items_;
+    std::map<std::string, double> counters_;
+    std::string label_;
+};
+
+typedef void (*Function)(State& state);
+
+class Benchmark {
+public:
+    Benchmark(const std::string& name, Function function);
+
+    // Run once per argument, named "name/arg"
+    Benchmark* arg(long value);
+    // Powers of multiplier from low to high, both included
+    Benchmark* range(long low, long high, long multiplier = 8);
+
+    const std::string& getName() const { return name_; }
+    Function getFunction() const { return function_; }
+    const std::vector<long>& getArgs() const { return args_; }
+
+private:
+    std::string name_;
+    Function function_;
+    std::vector<long> args_;
+};
+
+Benchmark* registerBenchmark(const char* name, Function function);
+
+// Heap allocations made so far by this process; the suite replaces the
+// global operator new to count them
+long long allocationCount();
+
+// Scratch directory for file benchmarks, removed with its contents
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+
+    const std::string& getPath() const { return path_; }
+
+private:
+    TempDir(const TempDir&);
+    TempDir& operator=(const TempDir&);
+
+    std::string path_;
+};
+
+// Parse the command line, run the matching benchmarks and print the
+// results; returns the exit status
+int runBenchmarks(int argc, char** argv);
+
+} // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(function) \
+    static ::bench::Benchmark* BENCH_CONCAT(benchmark_, __LINE__) = \
+        ::bench::registerBenchmark(#function, function)
+
+#endif // CVIM_BENCH_H
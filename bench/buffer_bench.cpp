@@ -0,0 +1,177 @@
+// Buffer file I/O and BufferUtils edits
+
+#include "bench.h"
+#include "modules/editor.h"
+#include "modules/buffer_utils.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cvim;
+
+namespace {
+
+const int BUFFER_LINES = 100000;
+
+std::string makeLine(int row) {
+    std::string line = "    line " + std::to_string(row) + ": the quick brown fox jumps over the lazy dog";
+    line.resize(79, '.');
+    return line;
+}
+
+void fillBuffer(Buffer& buffer, int lineCount) {
+    std::vector<std::string>& lines = buffer.getMutableLines();
+    lines.clear();
+    for (int row = 0; row < lineCount; ++row) {
+        lines.push_back(makeLine(row));
+    }
+}
+
+// Benchmark arguments give the edit position as a percentage of the buffer:
+// 0 is the head, 50 the middle, 100 the tail
+int positionOf(const bench::State& state, int size) {
+    return static_cast<int>(static_cast<long long>(size) * state.range() / 100);
+}
+
+} // namespace
+
+static void BM_BufferLoad(bench::State& state) {
+    bench::TempDir dir;
+    std::string path = dir.getPath() + "/load.txt";
+    {
+        std::ofstream file(path.c_str());
+        for (long row = 0; row < state.range(); ++row) {
+            file << makeLine(static_cast<int>(row)) << '\n';
+        }
+    }
+
+    while (state.keepRunning()) {
+        Buffer buffer(path);
+        buffer.load();
+    }
+    state.setBytesProcessed(static_cast<long long>(state.iterations()) * state.range() * 80);
+}
+BENCHMARK(BM_BufferLoad)->arg(1000)->arg(100000);
+
+// Includes the fsync of the atomic save
+static void BM_BufferSave(bench::State& state) {
+    bench::TempDir dir;
+    Buffer buffer(dir.getPath() + "/save.txt");
+    fillBuffer(buffer, static_cast<int>(state.range()));
+
+    while (state.keepRunning()) {
+        buffer.save();
+    }
+    state.setBytesProcessed(static_cast<long long>(state.iterations()) * state.range() * 80);
+}
+BENCHMARK(BM_BufferSave)->arg(1000)->arg(100000);
+
+// Inserted lines are removed in blocks, outside the timing
+static void BM_InsertLine(bench::State& state) {
+    const int BLOCK = 1024;
+    Buffer buffer;
+    fillBuffer(buffer, BUFFER_LINES);
+    std::vector<std::string> line(1, makeLine(0));
+    int row = positionOf(state, BUFFER_LINES);
+
+    long pending = 0;
+    while (state.keepRunning()) {
+        BufferUtils::insertLines(buffer, row, line);
+        if (++pending == BLOCK) {
+            state.pauseTiming();
+            BufferUtils::deleteLines(buffer, row, BLOCK);
+            pending = 0;
+            state.resumeTiming();
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InsertLine)->arg(0)->arg(50)->arg(100);
+
+static void BM_DeleteLine(bench::State& state) {
+    const int BLOCK = 1024;
+    Buffer buffer;
+    fillBuffer(buffer, BUFFER_LINES + BLOCK);
+    std::vector<std::string> block(BLOCK, makeLine(0));
+    int row = positionOf(state, BUFFER_LINES);
+
+    long pending = 0;
+    while (state.keepRunning()) {
+        BufferUtils::deleteLines(buffer, row, 1);
+        if (++pending == BLOCK) {
+            state.pauseTiming();
+            BufferUtils::insertLines(buffer, row, block);
+            pending = 0;
+            state.resumeTiming();
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeleteLine)->arg(0)->arg(50)->arg(100);
+
+// Typing into a long line, and deleting from it
+static void BM_InsertChar(bench::State& state) {
+    const int LENGTH = 4096;
+    Buffer buffer;
+    buffer.getMutableLines().assign(1, std::string(LENGTH, 'x'));
+    int col = positionOf(state, LENGTH);
+
+    long pending = 0;
+    while (state.keepRunning()) {
+        BufferUtils::insertCharAtPosition(buffer, 0, col, 'a');
+        if (++pending == LENGTH) {
+            state.pauseTiming();
+            buffer.getMutableLines()[0].resize(LENGTH);
+            pending = 0;
+            state.resumeTiming();
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InsertChar)->arg(0)->arg(50)->arg(100);
+
+static void BM_DeleteChar(bench::State& state) {
+    const int LENGTH = 4096;
+    Buffer buffer;
+    buffer.getMutableLines().assign(1, std::string(2 * LENGTH, 'x'));
+    int col = positionOf(state, LENGTH);
+
+    long pending = 0;
+    while (state.keepRunning()) {
+        BufferUtils::deleteCharAtPosition(buffer, 0, col);
+        if (++pending == LENGTH) {
+            state.pauseTiming();
+            buffer.getMutableLines()[0].resize(2 * LENGTH, 'x');
+            pending = 0;
+            state.resumeTiming();
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DeleteChar)->arg(0)->arg(50)->arg(100);
+
+// w across a whole buffer, one line at a time
+static void BM_FindNextWordStart(bench::State& state) {
+    Buffer buffer;
+    fillBuffer(buffer, static_cast<int>(state.range()));
+    const std::vector<std::string>& lines = buffer.getLines();
+
+    long long words = 0;
+    long long bytes = 0;
+    while (state.keepRunning()) {
+        for (int row = 0; row < static_cast<int>(lines.size()); ++row) {
+            int length = static_cast<int>(lines[row].size());
+            int col = 0;
+            while (col < length) {
+                int next = BufferUtils::findNextWordStart(buffer, row, col);
+                if (next <= col) break;
+                col = next;
+                ++words;
+            }
+            bytes += length;
+        }
+    }
+    state.setItemsProcessed(words);
+    state.setBytesProcessed(bytes);
+}
+BENCHMARK(BM_FindNextWordStart)->arg(1000)->arg(100000);
@@ -0,0 +1,42 @@
+// FileTree::loadDirectory on synthetic directory trees
+
+#include "bench.h"
+#include "modules/filetree.h"
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+using namespace cvim;
+
+namespace {
+
+// Directories of 16 entries, nested until about fileCount files exist
+void makeTree(const std::string& path, long fileCount) {
+    const long FANOUT = 16;
+    if (fileCount <= FANOUT) {
+        for (long i = 0; i < fileCount; ++i) {
+            std::ofstream file((path + "/file" + std::to_string(i) + ".cpp").c_str());
+        }
+        return;
+    }
+    for (long i = 0; i < FANOUT; ++i) {
+        std::string child = path + "/dir" + std::to_string(i);
+        mkdir(child.c_str(), 0755);
+        makeTree(child, fileCount / FANOUT);
+    }
+}
+
+} // namespace
+
+// Argument: number of files in the tree
+static void BM_LoadDirectory(bench::State& state) {
+    bench::TempDir dir;
+    makeTree(dir.getPath(), state.range());
+
+    while (state.keepRunning()) {
+        FileTree tree;
+        tree.loadDirectory(dir.getPath());
+    }
+    state.setItemsProcessed(static_cast<long long>(state.iterations()) * state.range());
+}
+BENCHMARK(BM_LoadDirectory)->arg(256)->arg(4096);
@@ -0,0 +1,48 @@
+// HotkeyManager::handleKey dispatch cost per keystroke while replaying a
+// long normal-mode macro.
+
+#include "bench.h"
+#include "modules/editor.h"
+#include "modules/hotkeys.h"
+#include "config/config.h"
+#include <string>
+#include <vector>
+
+using namespace cvim;
+
+static KeyInput makeKey(char c) {
+    KeyInput input;
+    input.key = Key::NORMAL;
+    input.character = c;
+    input.shift = false;
+    input.ctrl = false;
+    input.alt = false;
+    return input;
+}
+
+static void BM_HandleKey(bench::State& state) {
+    Config config;
+    Editor editor;
+    editor.initialize(nullptr, &config);
+
+    HotkeyManager hotkeys(&editor);
+
+    // Motions only, so the macro can run indefinitely without changing text
+    const std::string pattern = "jjjkkkllhhwbe0$lhjk";
+    std::vector<KeyInput> macro;
+    for (size_t i = 0; i < 4096; ++i) {
+        macro.push_back(makeKey(pattern[i % pattern.size()]));
+    }
+
+    // Warm up
+    for (size_t i = 0; i < macro.size(); ++i) {
+        hotkeys.handleKey(Mode::NORMAL, macro[i]);
+    }
+
+    long i = 0;
+    while (state.keepRunning()) {
+        hotkeys.handleKey(Mode::NORMAL, macro[i++ & 4095]);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HandleKey);
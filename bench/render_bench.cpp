@@ -0,0 +1,142 @@
+// Terminal::render cost and output size per frame
+
+#include "bench.h"
+#include "replay.h"
+#include "modules/terminal.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace cvim;
+
+namespace {
+
+// Counts what render() writes instead of sending it to the terminal
+class CountingBuffer : public std::streambuf {
+public:
+    CountingBuffer() : bytes_(0) {}
+
+    long long getBytes() const { return bytes_; }
+
+protected:
+    int overflow(int c) {
+        if (c != traits_type::eof()) ++bytes_;
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) {
+        bytes_ += count;
+        return count;
+    }
+
+private:
+    long long bytes_;
+};
+
+const int SCREEN_ROWS = 24;
+const int SCREEN_COLS = 80;
+const int TEXT_LINES = 1000;
+
+// One frame per line the view can scroll to, each one line further down
+// than the last, as j at the bottom of the screen would show them.
+// Argument: characters per line of text.
+std::vector<ViewData> makeFrames(long lineLength) {
+    static const char* const WORDS[] = { "the ", "quick ", "brown ", "fox ", "jumps ",
+                                         "over ", "the ", "lazy ", "dog; " };
+    std::vector<std::string> lines;
+    for (int row = 0; row < TEXT_LINES; ++row) {
+        std::string line = std::to_string(row + 1);
+        line.insert(0, 4 - std::min<size_t>(4, line.size()), ' ');
+        line += ' ';
+        for (int word = row; line.size() < static_cast<size_t>(lineLength); ++word) {
+            line += WORDS[word % 9];
+        }
+        line.resize(static_cast<size_t>(lineLength));
+        lines.push_back(line);
+    }
+
+    int textRows = SCREEN_ROWS - 2;
+    std::vector<ViewData> frames;
+    for (int top = 0; top + textRows <= TEXT_LINES; ++top) {
+        ViewData view;
+        view.lines.assign(lines.begin() + top, lines.begin() + top + textRows);
+        view.cursorRow = textRows - 1;
+        view.cursorCol = 5;
+        view.statusLine = "[NORMAL] bench.txt [+] - Line " + std::to_string(top + textRows) +
+                          "/" + std::to_string(TEXT_LINES) + " Col 6";
+        view.mode = "NORMAL";
+        frames.push_back(view);
+    }
+    return frames;
+}
+
+// Draw the frames in order into a virtual terminal and compare the screen
+// with each; exits on the first one that does not show
+void checkFrames(const std::vector<ViewData>& frames, bool fullRedraw) {
+    bench::VirtualTerminal screen(SCREEN_ROWS, SCREEN_COLS);
+    std::ostream out(&screen);
+    Terminal terminal;
+    terminal.setOutput(&out);
+    Size size = { SCREEN_ROWS, SCREEN_COLS };
+    terminal.setSize(size);
+
+    // Once more at the start, after the jump back from the end
+    for (size_t i = 0; i <= frames.size(); ++i) {
+        const ViewData& view = frames[i % frames.size()];
+        if (fullRedraw) terminal.clearScreen();
+        terminal.render(view);
+        std::string error;
+        if (!bench::showsView(screen, view, error)) {
+            fprintf(stderr, "cvim_bench: frame %d: %s\n", static_cast<int>(i), error.c_str());
+            exit(1);
+        }
+    }
+}
+
+// Scrolls one line per frame; with fullRedraw every frame starts from a
+// cleared screen, as after a resize or ^L
+void runRender(bench::State& state, bool fullRedraw) {
+    std::vector<ViewData> frames = makeFrames(state.range());
+    checkFrames(frames, fullRedraw);
+
+    CountingBuffer counter;
+    std::ostream out(&counter);
+    {
+        // Not initialized: no raw mode
+        Terminal terminal;
+        terminal.setOutput(&out);
+        Size size = { SCREEN_ROWS, SCREEN_COLS };
+        terminal.setSize(size);
+        terminal.render(frames.back());
+
+        long long before = counter.getBytes();
+        size_t frame = 0;
+        while (state.keepRunning()) {
+            if (fullRedraw) terminal.clearScreen();
+            terminal.render(frames[frame]);
+            if (++frame == frames.size()) frame = 0;
+        }
+        long long bytes = counter.getBytes() - before;
+
+        state.setBytesProcessed(bytes);
+        state.setCounter("bytes_per_frame", static_cast<double>(bytes) / state.iterations());
+        state.setCounter("rows", terminal.getSize().height);
+        state.setCounter("cols", terminal.getSize().width);
+    }
+}
+
+} // namespace
+
+static void BM_Render(bench::State& state) {
+    runRender(state, false);
+}
+BENCHMARK(BM_Render)->arg(40)->arg(80)->arg(200);
+
+static void BM_RenderFullRedraw(bench::State& state) {
+    runRender(state, true);
+}
+BENCHMARK(BM_RenderFullRedraw)->arg(40)->arg(80)->arg(200);
@@ -0,0 +1,170 @@
+#include "replay.h"
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace bench {
+
+VirtualTerminal::VirtualTerminal(int rows, int cols)
+    : screen_(rows, std::string(cols, ' ')), cols_(cols), cursorRow_(0), cursorCol_(0),
+      state_(TEXT), bytes_(0) {}
+
+std::string VirtualTerminal::getRow(int row) const {
+    const std::string& text = screen_[row];
+    size_t end = text.find_last_not_of(' ');
+    return end == std::string::npos ? std::string() : text.substr(0, end + 1);
+}
+
+int VirtualTerminal::overflow(int c) {
+    if (c != traits_type::eof()) {
+        ++bytes_;
+        put(static_cast<char>(c));
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize VirtualTerminal::xsputn(const char* data, std::streamsize count) {
+    bytes_ += count;
+    for (std::streamsize i = 0; i < count; ++i) {
+        put(data[i]);
+    }
+    return count;
+}
+
+void VirtualTerminal::put(char c) {
+    switch (state_) {
+        case TEXT:
+            if (c == 27) {
+                state_ = ESCAPE;
+            } else if (c == '\r') {
+                cursorCol_ = 0;
+            } else if (c == '\n') {
+                newline();
+            } else {
+                // Autowrap, like a real terminal
+                if (cursorCol_ >= cols_) {
+                    cursorCol_ = 0;
+                    newline();
+                }
+                screen_[cursorRow_][cursorCol_++] = c;
+            }
+            break;
+        case ESCAPE:
+            if (c == '[') {
+                state_ = CSI;
+                params_.clear();
+            } else {
+                state_ = TEXT;
+            }
+            break;
+        case CSI:
+            if ((c >= '0' && c <= '9') || c == ';' || c == '?') {
+                params_ += c;
+            } else {
+                control(c);
+                state_ = TEXT;
+            }
+            break;
+    }
+}
+
+void VirtualTerminal::control(char final) {
+    int first = atoi(params_.c_str());
+    size_t separator = params_.find(';');
+    int second = separator == std::string::npos ? 0 : atoi(params_.c_str() + separator + 1);
+    int rows = getRows();
+
+    if (final == 'H') {
+        // 1-based, clamped to the screen
+        cursorRow_ = std::max(0, std::min(std::max(first, 1) - 1, rows - 1));
+        cursorCol_ = std::max(0, std::min(std::max(second, 1) - 1, cols_ - 1));
+    } else if (final == 'J' && first == 2) {
+        for (int row = 0; row < rows; ++row) {
+            screen_[row].assign(cols_, ' ');
+        }
+    } else if (final == 'K') {
+        // Erase to the end of the line
+        if (cursorCol_ < cols_) {
+            screen_[cursorRow_].replace(cursorCol_, cols_ - cursorCol_, cols_ - cursorCol_, ' ');
+        }
+    }
+    // Anything else (modes, colors) does not change the text
+}
+
+void VirtualTerminal::newline() {
+    if (cursorRow_ + 1 < getRows()) {
+        ++cursorRow_;
+    } else {
+        screen_.erase(screen_.begin());
+        screen_.push_back(std::string(cols_, ' '));
+    }
+}
+
+bool showsView(const VirtualTerminal& screen, const cvim::ViewData& view, std::string& error) {
+    int rows = screen.getRows();
+    int cols = screen.getCols();
+    for (int row = 0; row < rows; ++row) {
+        std::string expected;
+        if (row < rows - 2) {
+            if (row < static_cast<int>(view.lines.size())) expected = view.lines[row];
+        } else if (row == rows - 2) {
+            expected = view.statusLine;
+        } else {
+            expected = view.mode + ' ' + view.commandLine;
+        }
+        size_t width = static_cast<size_t>(row == rows - 1 ? cols - 1 : cols);
+        if (expected.size() > width) expected.resize(width);
+        expected.erase(expected.find_last_not_of(' ') + 1);
+
+        std::string shown = screen.getRow(row);
+        if (shown != expected) {
+            error = "row " + std::to_string(row) + " shows \"" + shown + "\", expected \"" + expected + "\"";
+            return false;
+        }
+    }
+    if (screen.getCursorRow() != view.cursorRow || screen.getCursorCol() != view.cursorCol) {
+        error = "cursor at " + std::to_string(screen.getCursorRow()) + "," + std::to_string(screen.getCursorCol()) +
+                ", expected " + std::to_string(view.cursorRow) + "," + std::to_string(view.cursorCol);
+        return false;
+    }
+    return true;
+}
+
+double ReplayStats::percentile(double fraction) {
+    if (latenciesNs.empty()) return 0;
+    size_t index = std::min(latenciesNs.size() - 1, static_cast<size_t>(latenciesNs.size() * fraction));
+    std::nth_element(latenciesNs.begin(), latenciesNs.begin() + index, latenciesNs.end());
+    return latenciesNs[index];
+}
+
+double ReplayStats::bytesPerFrame() const {
+    return frames > 0 ? static_cast<double>(bytes) / frames : 0;
+}
+
+double ReplayStats::allocationsPerKey() const {
+    return latenciesNs.empty() ? 0 : static_cast<double>(allocations) / latenciesNs.size();
+}
+
+void replayKeys(cvim::Editor& editor, cvim::Terminal& terminal, VirtualTerminal& screen,
+                const std::vector<cvim::KeyInput>& keys, ReplayStats& stats) {
+    // Reserved up front so only the editor's allocations are counted
+    stats.latenciesNs.reserve(stats.latenciesNs.size() + keys.size());
+    long long bytesBefore = screen.getBytes();
+    long long allocationsBefore = allocationCount();
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        editor.handleInput(keys[i]);
+        terminal.render(editor.getViewData());
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        stats.latenciesNs.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    stats.frames += static_cast<long long>(keys.size());
+    stats.bytes += screen.getBytes() - bytesBefore;
+    stats.allocations += allocationCount() - allocationsBefore;
+}
+
+} // namespace bench
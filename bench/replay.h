@@ -0,0 +1,78 @@
+// Deterministic keystroke replay: keys go through Editor::handleInput and
+// every frame is rendered into an in-memory terminal, so end-to-end
+// latency can be measured without a tty.
+
+#ifndef CVIM_BENCH_REPLAY_H
+#define CVIM_BENCH_REPLAY_H
+
+#include "modules/editor.h"
+#include "modules/terminal.h"
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Output sink for Terminal that interprets the escape sequences it emits
+// (cursor moves, clears) into a character grid and counts the bytes
+class VirtualTerminal : public std::streambuf {
+public:
+    VirtualTerminal(int rows, int cols);
+
+    int getRows() const { return static_cast<int>(screen_.size()); }
+    int getCols() const { return cols_; }
+    // Row text with trailing blanks removed
+    std::string getRow(int row) const;
+    int getCursorRow() const { return cursorRow_; }
+    int getCursorCol() const { return cursorCol_; }
+    long long getBytes() const { return bytes_; }
+
+protected:
+    int overflow(int c);
+    std::streamsize xsputn(const char* data, std::streamsize count);
+
+private:
+    void put(char c);
+    void control(char final);
+    void newline();
+
+    enum ParseState { TEXT, ESCAPE, CSI };
+
+    std::vector<std::string> screen_;
+    int cols_;
+    int cursorRow_;
+    int cursorCol_;
+    ParseState state_;
+    std::string params_;
+    long long bytes_;
+};
+
+// Whether screen shows view as Terminal::render() draws it at the
+// screen's size: text rows, then the status and command lines, clipped to
+// the width (the bottom row one cell short), and the cursor. The grid holds
+// bytes, so this is exact for ASCII without tabs. If not, error says where.
+bool showsView(const VirtualTerminal& screen, const cvim::ViewData& view, std::string& error);
+
+// Percentiles are over the time from handing a key to the editor until its
+// frame has been rendered
+struct ReplayStats {
+    std::vector<double> latenciesNs;
+    long long frames;
+    long long bytes;
+    long long allocations;
+
+    ReplayStats() : frames(0), bytes(0), allocations(0) {}
+
+    double percentile(double fraction);
+    double bytesPerFrame() const;
+    double allocationsPerKey() const;
+};
+
+// Feed keys one at a time and render after each, as the main loop does
+// when keys arrive slower than the frame rate
+void replayKeys(cvim::Editor& editor, cvim::Terminal& terminal, VirtualTerminal& screen,
+                const std::vector<cvim::KeyInput>& keys, ReplayStats& stats);
+
+} // namespace bench
+
+#endif // CVIM_BENCH_REPLAY_H
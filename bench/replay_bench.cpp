@@ -0,0 +1,153 @@
+// End-to-end keystroke latency: scripted sessions replayed through the
+// editor and rendered into a virtual terminal
+
+#include "bench.h"
+#include "replay.h"
+#include "modules/keynotation.h"
+#include "config/config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cvim;
+
+namespace {
+
+const int SCREEN_ROWS = 24;
+const int SCREEN_COLS = 80;
+
+std::vector<std::string> makeLines(int count) {
+    std::vector<std::string> lines;
+    for (int row = 0; row < count; ++row) {
+        lines.push_back("    line " + std::to_string(row) + ": the quick brown fox jumps over the lazy dog;");
+    }
+    return lines;
+}
+
+std::string repeat(const std::string& keys, int count) {
+    std::string script;
+    for (int i = 0; i < count; ++i) {
+        script += keys;
+    }
+    return script;
+}
+
+// Setup and teardown of the editor are not timed; the counters describe
+// every key of every iteration
+void runReplay(bench::State& state, const std::string& script, const std::vector<std::string>& lines) {
+    std::vector<KeyInput> keys;
+    std::string error;
+    if (!parseKeys(script, keys, error)) {
+        fprintf(stderr, "cvim_bench: %s\n", error.c_str());
+        exit(1);
+    }
+
+    bench::ReplayStats stats;
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        {
+            Config config;
+            Editor editor;
+            editor.initialize(nullptr, &config);
+            editor.getCurrentBuffer()->getMutableLines() = lines;
+
+            bench::VirtualTerminal screen(SCREEN_ROWS, SCREEN_COLS);
+            std::ostream out(&screen);
+            Terminal terminal;
+            terminal.setOutput(&out);
+            Size size = { SCREEN_ROWS, SCREEN_COLS };
+            terminal.setSize(size);
+
+            state.resumeTiming();
+            bench::replayKeys(editor, terminal, screen, keys, stats);
+            state.pauseTiming();
+        }
+        state.resumeTiming();
+    }
+
+    state.setItemsProcessed(static_cast<long long>(stats.latenciesNs.size()));
+    state.setCounter("keys", static_cast<double>(keys.size()));
+    state.setCounter("p50_ns", stats.percentile(0.50));
+    state.setCounter("p99_ns", stats.percentile(0.99));
+    state.setCounter("max_ns", stats.percentile(1.0));
+    state.setCounter("bytes_per_frame", stats.bytesPerFrame());
+    state.setCounter("allocs_per_key", stats.allocationsPerKey());
+}
+
+} // namespace
+
+static void BM_ReplayTyping(bench::State& state) {
+    runReplay(state, "i" + repeat("The quick brown fox jumps over the lazy dog.<CR>", 40) + "<Esc>",
+              std::vector<std::string>(1, std::string()));
+}
+BENCHMARK(BM_ReplayTyping);
+
+static void BM_ReplayNavigation(bench::State& state) {
+    runReplay(state, repeat("jjjjjkkwwwbbe$0", 50) + "Ggg50G" + repeat("<Down><Down><Right><Up>", 20),
+              makeLines(10000));
+}
+BENCHMARK(BM_ReplayNavigation);
+
+static void BM_ReplayEditing(bench::State& state) {
+    runReplay(state, repeat("ddpxyyPJcwnew<Esc>.A;<Esc>o// note<Esc>j", 30), makeLines(1000));
+}
+BENCHMARK(BM_ReplayEditing);
+
+static void BM_ReplayCommands(bench::State& state) {
+    runReplay(state, repeat(":set ts=8<CR>:%s/fox/cat/g<CR>:%s/cat/fox/g<CR>:500<CR>", 5),
+              makeLines(1000));
+}
+BENCHMARK(BM_ReplayCommands);
+
+// Minified JSON on one 5 MB line, wrapped: after the first frame lays the
+// line out, moving through it and redrawing cost only the rows on screen
+static void BM_ReplayWrappedLongLine(bench::State& state) {
+    std::string line;
+    for (int i = 0; line.size() < 5000000; ++i) {
+        line += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\",\"tags\":[\"a\",\"b\"]},";
+    }
+    runReplay(state, ":set wrap<CR>" + repeat("gj", 200) + "$" + repeat("gkgkgkl", 50) + "0",
+              std::vector<std::string>(1, line));
+}
+BENCHMARK(BM_ReplayWrappedLongLine);
+
+// Wide CSV rows, not wrapped: scrolled far to the right, each frame draws
+// only the columns on screen, found through the line's column index
+static void BM_ReplaySideScroll(bench::State& state) {
+    std::vector<std::string> lines;
+    for (int row = 0; row < 40; ++row) {
+        std::string line;
+        for (int i = 0; line.size() < 200000; ++i) {
+            line += std::to_string(row * 100000 + i) + ",\xe5\x90\x8d\xe5\x89\x8d,\tfield,";
+        }
+        lines.push_back(line);
+    }
+    runReplay(state, "50000l" + repeat("jzl", 100) + repeat("kzh", 100) + "$" + repeat("jzH", 20) + "0",
+              lines);
+}
+BENCHMARK(BM_ReplaySideScroll);
+
+// A real session: record it with cvim --record keys.txt file, then run
+// CVIM_REPLAY_SCRIPT=keys.txt CVIM_REPLAY_FILE=file cvim_bench --filter=Recorded
+// The file's contents are replayed in an unnamed buffer, so :w cannot touch it.
+static void BM_ReplayRecorded(bench::State& state) {
+    std::ifstream scriptFile(getenv("CVIM_REPLAY_SCRIPT"));
+    std::stringstream script;
+    script << scriptFile.rdbuf();
+
+    std::vector<std::string> lines(1, std::string());
+    const char* path = getenv("CVIM_REPLAY_FILE");
+    if (path) {
+        Buffer buffer(path);
+        if (buffer.load()) {
+            lines = buffer.getLines();
+        }
+    }
+    runReplay(state, script.str(), lines);
+}
+static bench::Benchmark* recordedBenchmark =
+    getenv("CVIM_REPLAY_SCRIPT") ? bench::registerBenchmark("BM_ReplayRecorded", BM_ReplayRecorded) : NULL;
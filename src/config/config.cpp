@@ -18,16 +18,12 @@ Config::Config() {
 Config::~Config() {}
 
 void Config::loadDefaults() {
-    // General settings
-    settings_["tabSize"] = "4";
-    settings_["expandTab"] = "true";
-    settings_["lineNumbers"] = "true";
-    settings_["relativeLine"] = "false";
-    settings_["wrapText"] = "false";
-    settings_["syntax"] = "true";
-    settings_["autoIndent"] = "true";
-    settings_["showStatusLine"] = "true";
-    settings_["theme"] = "default";
+    // General settings; the defaults live with their types in settings.cpp
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        SettingId id = static_cast<SettingId>(i);
+        settings_[Settings::getName(id)] = Settings::getDefault(id);
+    }
+    syncSettings();
     
     // Default color scheme
     colorScheme_.foreground = 7;   // White
@@ -45,15 +41,25 @@ void Config::loadDefaults() {
     // Default key bindings are managed by the Editor class
 }
 
+void Config::syncSettings() {
+    // Values that do not parse leave the previous one in place
+    for (std::map<std::string, std::string>::const_iterator it = settings_.begin(); it != settings_.end(); ++it) {
+        typedSettings_.set(it->first, it->second);
+    }
+}
+
 bool Config::load(const std::string& configPath) {
     if (!configPath.empty()) {
         configPath_ = configPath;
-    } else {
+    } else if (configPath_.empty()) {
         configPath_ = getUserConfigPath();
     }
     
+    error_.clear();
     if (fileExists(configPath_)) {
-        return loadFromFile(configPath_);
+        bool loaded = loadFromFile(configPath_);
+        syncSettings();
+        return loaded;
     }
     
     return false;
@@ -68,6 +74,59 @@ bool Config::save(const std::string& configPath) {
     return saveToFile(path);
 }
 
+static bool sameColors(const ColorScheme& a, const ColorScheme& b) {
+    return a.foreground == b.foreground && a.background == b.background &&
+           a.selection == b.selection && a.lineNumber == b.lineNumber &&
+           a.statusLine == b.statusLine && a.commandLine == b.commandLine &&
+           a.errorMessage == b.errorMessage && a.keyword == b.keyword &&
+           a.string == b.string && a.comment == b.comment && a.number == b.number;
+}
+
+static bool sameKeyBindings(const std::vector<KeyBinding>& a, const std::vector<KeyBinding>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].mode != b[i].mode || a[i].key != b[i].key || a[i].action != b[i].action) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int Config::update(const Config& other) {
+    int changes = 0;
+    if (settings_ != other.settings_) {
+        // Only the keys the file changed: the rest may have been :set since
+        typedef std::map<std::string, std::string>::const_iterator Iterator;
+        for (Iterator it = other.settings_.begin(); it != other.settings_.end(); ++it) {
+            Iterator old = settings_.find(it->first);
+            if (old == settings_.end() || old->second != it->second) {
+                typedSettings_.set(it->first, it->second);
+            }
+        }
+        for (Iterator it = settings_.begin(); it != settings_.end(); ++it) {
+            SettingId id;
+            if (other.settings_.count(it->first) == 0 && Settings::lookup(it->first, id)) {
+                typedSettings_.set(id, Settings::getDefault(id));
+            }
+        }
+        settings_ = other.settings_;
+        changes |= CONFIG_SETTINGS_CHANGED;
+    }
+    if (!sameColors(colorScheme_, other.colorScheme_)) {
+        colorScheme_ = other.colorScheme_;
+        changes |= CONFIG_COLORS_CHANGED;
+    }
+    if (!sameKeyBindings(keyBindings_, other.keyBindings_)) {
+        keyBindings_ = other.keyBindings_;
+        changes |= CONFIG_KEYBINDINGS_CHANGED;
+    }
+    return changes;
+}
+
+const std::string& Config::getError() const {
+    return error_;
+}
+
 bool Config::loadFromFile(const std::string& path) {
 #ifdef HAS_YAML_CPP
     try {
@@ -112,13 +171,15 @@ bool Config::loadFromFile(const std::string& path) {
         
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Error loading config file: " << e.what() << std::endl;
+        // Reported by the caller: a reload runs while the editor owns the screen
+        error_ = std::string("Error loading config file: ") + e.what();
         return false;
     }
 #else
     // Fallback simple loading when yaml-cpp is not available
     std::ifstream file(path);
     if (!file.is_open()) {
+        error_ = "Cannot open " + path;
         return false;
     }
     
@@ -196,6 +257,11 @@ bool Config::saveToFile(const std::string& path) {
 }
 
 bool Config::getBoolean(const std::string& key, bool defaultValue) const {
+    SettingId id;
+    if (Settings::lookup(key, id) && Settings::getType(id) == Settings::TYPE_BOOLEAN) {
+        return typedSettings_.getBoolean(id);
+    }
+    
     auto it = settings_.find(key);
     if (it == settings_.end()) {
         return defaultValue;
@@ -206,6 +272,11 @@ bool Config::getBoolean(const std::string& key, bool defaultValue) const {
 }
 
 int Config::getInteger(const std::string& key, int defaultValue) const {
+    SettingId id;
+    if (Settings::lookup(key, id) && Settings::getType(id) == Settings::TYPE_INTEGER) {
+        return typedSettings_.getInteger(id);
+    }
+    
     auto it = settings_.find(key);
     if (it == settings_.end()) {
         return defaultValue;
@@ -219,6 +290,11 @@ int Config::getInteger(const std::string& key, int defaultValue) const {
 }
 
 std::string Config::getString(const std::string& key, const std::string& defaultValue) const {
+    SettingId id;
+    if (Settings::lookup(key, id)) {
+        return typedSettings_.toString(id);
+    }
+    
     auto it = settings_.find(key);
     if (it == settings_.end()) {
         return defaultValue;
@@ -229,14 +305,17 @@ std::string Config::getString(const std::string& key, const std::string& default
 
 void Config::setBoolean(const std::string& key, bool value) {
     settings_[key] = value ? "true" : "false";
+    typedSettings_.set(key, settings_[key]);
 }
 
 void Config::setInteger(const std::string& key, int value) {
     settings_[key] = std::to_string(value);
+    typedSettings_.set(key, settings_[key]);
 }
 
 void Config::setString(const std::string& key, const std::string& value) {
     settings_[key] = value;
+    typedSettings_.set(key, value);
 }
 
 ColorScheme Config::getColorScheme() const {
@@ -269,7 +348,7 @@ void Config::setColorTheme(ColorTheme theme) {
             break;
     }
     
-    settings_["theme"] = "custom";
+    setString("theme", "custom");
 }
 
 std::vector<KeyBinding> Config::getKeyBindings() const {
@@ -299,6 +378,10 @@ void Config::removeKeyBinding(const std::string& mode, const std::string& key) {
     );
 }
 
+void Config::setConfigPath(const std::string& configPath) {
+    configPath_ = configPath;
+}
+
 std::string Config::getConfigPath() const {
     return configPath_;
 }
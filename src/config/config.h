@@ -5,6 +5,7 @@
 #include <map>
 #include <vector>
 #include <functional>
+#include "settings.h"
 #include "../utils/utils.h"
 
 namespace cvim {
@@ -39,15 +40,37 @@ struct KeyBinding {
     std::string action;
 };
 
+// What Config::update() changed, as bits
+enum ConfigChange {
+    CONFIG_SETTINGS_CHANGED = 1,
+    CONFIG_COLORS_CHANGED = 2,
+    CONFIG_KEYBINDINGS_CHANGED = 4
+};
+
 class Config {
 public:
     Config();
     ~Config();
     
+    // Without a path: the one set by setConfigPath(), else ~/.cvimrc
     bool load(const std::string& configPath = "");
     bool save(const std::string& configPath = "");
     
-    // General settings
+    // Take over settings, colors and key bindings from a freshly loaded
+    // config (e.g. parsed on a worker after the file changed). Only settings
+    // whose value in the file changed reach the typed store, so a :set of
+    // any other survives. Returns ConfigChange bits.
+    int update(const Config& other);
+    
+    // Why the last load failed, if it did
+    const std::string& getError() const;
+    
+    // Typed store of the known options; prefer it on hot paths, it never
+    // parses. Loading and the setters below keep it in sync.
+    Settings& getSettings() { return typedSettings_; }
+    const Settings& getSettings() const { return typedSettings_; }
+    
+    // General settings, by name; known options read the typed store
     bool getBoolean(const std::string& key, bool defaultValue = false) const;
     int getInteger(const std::string& key, int defaultValue = 0) const;
     std::string getString(const std::string& key, const std::string& defaultValue = "") const;
@@ -67,18 +90,22 @@ public:
     void removeKeyBinding(const std::string& mode, const std::string& key);
     
     // Paths
+    void setConfigPath(const std::string& configPath);
     std::string getConfigPath() const;
     std::string getUserConfigPath() const;
     
 private:
     void loadDefaults();
+    void syncSettings();
     bool loadFromFile(const std::string& path);
     bool saveToFile(const std::string& path);
     
     std::map<std::string, std::string> settings_;
+    Settings typedSettings_;
     std::vector<KeyBinding> keyBindings_;
     ColorScheme colorScheme_;
     std::string configPath_;
+    std::string error_;
 };
 
 } // namespace cvim
@@ -0,0 +1,242 @@
+#include "settings.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+namespace cvim {
+
+namespace {
+
+struct SettingInfo {
+    const char* name;    // as written in the config file
+    const char* alias;   // vim's short name, or null
+    Settings::Type type;
+    const char* defaultValue;
+    int minimum;         // integers only
+};
+
+// Indexed by SettingId
+const SettingInfo SETTING_INFO[] = {
+    { "tabSize",        "ts",   Settings::TYPE_INTEGER, "4",       1 },
+    { "expandTab",      "et",   Settings::TYPE_BOOLEAN, "true",    0 },
+    { "lineNumbers",    "nu",   Settings::TYPE_BOOLEAN, "true",    0 },
+    { "relativeLine",   "rnu",  Settings::TYPE_BOOLEAN, "false",   0 },
+    { "wrapText",       "wrap", Settings::TYPE_BOOLEAN, "false",   0 },
+    { "syntax",         "syn",  Settings::TYPE_BOOLEAN, "true",    0 },
+    { "autoIndent",     "ai",   Settings::TYPE_BOOLEAN, "true",    0 },
+    { "showStatusLine", NULL,   Settings::TYPE_BOOLEAN, "true",    0 },
+    { "theme",          NULL,   Settings::TYPE_STRING,  "default", 0 },
+    // MB of inactive buffers kept loaded, 0 = unlimited
+    { "memoryBudget",   NULL,   Settings::TYPE_INTEGER, "512",     0 },
+    // ms to wait for the rest of an ambiguous key sequence
+    { "timeoutLen",     "tm",   Settings::TYPE_INTEGER, "1000",    0 },
+    // background worker threads, 0 = one per CPU; read at startup
+    { "threads",        NULL,   Settings::TYPE_INTEGER, "0",       0 },
+    // latency, frame time and size, and memory in the status line
+    { "showPerf",       "showperf", Settings::TYPE_BOOLEAN, "false", 0 },
+    // columns to scroll sideways when the cursor leaves the screen, 0 = half a screen
+    { "sideScroll",     "ss",   Settings::TYPE_INTEGER, "0",       0 },
+};
+
+static_assert(sizeof(SETTING_INFO) / sizeof(SETTING_INFO[0]) == SETTING_COUNT,
+              "every SettingId needs an entry in SETTING_INFO");
+
+bool parseBoolean(const std::string& value, bool& result) {
+    if (value == "true" || value == "yes" || value == "on" || value == "1") {
+        result = true;
+        return true;
+    }
+    if (value == "false" || value == "no" || value == "off" || value == "0") {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+bool parseInteger(const std::string& value, int& result) {
+    if (value.empty()) return false;
+
+    char* end = NULL;
+    errno = 0;
+    long parsed = strtol(value.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) {
+        return false;
+    }
+    result = static_cast<int>(parsed);
+    return true;
+}
+
+} // namespace
+
+Settings::Settings() : nextListenerId_(0) {
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        values_[i].number = 0;
+        set(static_cast<SettingId>(i), SETTING_INFO[i].defaultValue);
+    }
+}
+
+void Settings::setBoolean(SettingId id, bool value) {
+    setInteger(id, value ? 1 : 0);
+}
+
+void Settings::setInteger(SettingId id, int value) {
+    if (values_[id].number == value) return;
+    values_[id].number = value;
+    changed(id);
+}
+
+void Settings::setString(SettingId id, const std::string& value) {
+    if (values_[id].text == value) return;
+    values_[id].text = value;
+    changed(id);
+}
+
+bool Settings::set(SettingId id, const std::string& value) {
+    switch (SETTING_INFO[id].type) {
+        case TYPE_BOOLEAN: {
+            bool parsed;
+            if (!parseBoolean(value, parsed)) return false;
+            setBoolean(id, parsed);
+            return true;
+        }
+        case TYPE_INTEGER: {
+            int parsed;
+            if (!parseInteger(value, parsed) || parsed < SETTING_INFO[id].minimum) return false;
+            setInteger(id, parsed);
+            return true;
+        }
+        case TYPE_STRING:
+            setString(id, value);
+            return true;
+    }
+    return false;
+}
+
+bool Settings::set(const std::string& name, const std::string& value) {
+    SettingId id;
+    return lookup(name, id) && set(id, value);
+}
+
+std::string Settings::toString(SettingId id) const {
+    switch (SETTING_INFO[id].type) {
+        case TYPE_BOOLEAN:
+            return getBoolean(id) ? "true" : "false";
+        case TYPE_INTEGER:
+            return std::to_string(getInteger(id));
+        case TYPE_STRING:
+            return getString(id);
+    }
+    return "";
+}
+
+bool Settings::apply(const std::string& argument, std::string& message) {
+    std::string name = argument;
+    std::string value;
+    bool query = false;
+    bool invert = false;
+    bool negate = false;
+
+    size_t equals = argument.find('=');
+    if (equals != std::string::npos) {
+        name = argument.substr(0, equals);
+        value = argument.substr(equals + 1);
+    } else if (!name.empty() && name[name.size() - 1] == '?') {
+        name.erase(name.size() - 1);
+        query = true;
+    } else if (!name.empty() && name[name.size() - 1] == '!') {
+        name.erase(name.size() - 1);
+        invert = true;
+    }
+
+    SettingId id;
+    if (!lookup(name, id)) {
+        // "noname" and "invname" only exist for booleans
+        if (equals == std::string::npos && !query && !invert) {
+            if (name.compare(0, 2, "no") == 0 && lookup(name.substr(2), id) &&
+                getType(id) == TYPE_BOOLEAN) {
+                negate = true;
+            } else if (name.compare(0, 3, "inv") == 0 && lookup(name.substr(3), id) &&
+                       getType(id) == TYPE_BOOLEAN) {
+                invert = true;
+            } else {
+                message = "Unknown option: " + name;
+                return false;
+            }
+        } else {
+            message = "Unknown option: " + name;
+            return false;
+        }
+    }
+
+    bool boolean = getType(id) == TYPE_BOOLEAN;
+    if (equals != std::string::npos) {
+        if (!set(id, value)) {
+            message = "Invalid value: " + argument;
+            return false;
+        }
+    } else if (invert || negate) {
+        if (!boolean) {
+            message = "Invalid argument: " + argument;
+            return false;
+        }
+        setBoolean(id, invert ? !getBoolean(id) : false);
+    } else if (boolean && !query) {
+        setBoolean(id, true);
+    } else {
+        // A bare non-boolean name shows its value, like name?
+        if (boolean) {
+            message = std::string(getBoolean(id) ? "" : "no") + getName(id);
+        } else {
+            message = std::string(getName(id)) + "=" + toString(id);
+        }
+    }
+    return true;
+}
+
+bool Settings::lookup(const std::string& name, SettingId& id) {
+    for (int i = 0; i < SETTING_COUNT; ++i) {
+        if (name == SETTING_INFO[i].name ||
+            (SETTING_INFO[i].alias && name == SETTING_INFO[i].alias)) {
+            id = static_cast<SettingId>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* Settings::getName(SettingId id) {
+    return SETTING_INFO[id].name;
+}
+
+Settings::Type Settings::getType(SettingId id) {
+    return SETTING_INFO[id].type;
+}
+
+const char* Settings::getDefault(SettingId id) {
+    return SETTING_INFO[id].defaultValue;
+}
+
+int Settings::addListener(Listener listener) {
+    int listenerId = nextListenerId_++;
+    listeners_.push_back(std::make_pair(listenerId, listener));
+    return listenerId;
+}
+
+void Settings::removeListener(int listenerId) {
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        if (listeners_[i].first == listenerId) {
+            listeners_.erase(listeners_.begin() + i);
+            return;
+        }
+    }
+}
+
+void Settings::changed(SettingId id) {
+    // Copy: a listener may add or remove listeners
+    std::vector<std::pair<int, Listener> > listeners = listeners_;
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        listeners[i].second(id);
+    }
+}
+
+} // namespace cvim
@@ -0,0 +1,88 @@
+#ifndef CVIM_SETTINGS_H
+#define CVIM_SETTINGS_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace cvim {
+
+// Every option the editor knows about. Values are indices into
+// Settings, so a read is an array load; add new ones before SETTING_COUNT.
+enum SettingId {
+    SETTING_TAB_SIZE,
+    SETTING_EXPAND_TAB,
+    SETTING_LINE_NUMBERS,
+    SETTING_RELATIVE_LINE,
+    SETTING_WRAP_TEXT,
+    SETTING_SYNTAX,
+    SETTING_AUTO_INDENT,
+    SETTING_SHOW_STATUS_LINE,
+    SETTING_THEME,
+    SETTING_MEMORY_BUDGET,
+    SETTING_TIMEOUT_LEN,
+    SETTING_THREADS,
+    SETTING_SHOW_PERF,
+    SETTING_SIDE_SCROLL,
+    SETTING_COUNT
+};
+
+// Typed option store. Strings are parsed once, when a value is set; the
+// getters never parse or look anything up by name.
+class Settings {
+public:
+    enum Type {
+        TYPE_BOOLEAN,
+        TYPE_INTEGER,
+        TYPE_STRING
+    };
+
+    typedef std::function<void(SettingId)> Listener;
+
+    Settings();
+
+    bool getBoolean(SettingId id) const { return values_[id].number != 0; }
+    int getInteger(SettingId id) const { return values_[id].number; }
+    const std::string& getString(SettingId id) const { return values_[id].text; }
+
+    void setBoolean(SettingId id, bool value);
+    void setInteger(SettingId id, int value);
+    void setString(SettingId id, const std::string& value);
+
+    // Parse value according to the setting's type; false if it does not fit
+    bool set(SettingId id, const std::string& value);
+    // Same, by config name or short alias; false for unknown names
+    bool set(const std::string& name, const std::string& value);
+
+    // The value as it would be written to the config file
+    std::string toString(SettingId id) const;
+
+    // Apply one :set argument: "name", "noname", "invname", "name!",
+    // "name?", "name=value". message is set for queries and errors.
+    bool apply(const std::string& argument, std::string& message);
+
+    static bool lookup(const std::string& name, SettingId& id);
+    static const char* getName(SettingId id);
+    static Type getType(SettingId id);
+    static const char* getDefault(SettingId id);
+
+    // Called after a setting changes value; returns an id for removeListener
+    int addListener(Listener listener);
+    void removeListener(int listenerId);
+
+private:
+    struct Value {
+        int number;       // booleans and integers
+        std::string text; // strings
+    };
+
+    void changed(SettingId id);
+
+    Value values_[SETTING_COUNT];
+    std::vector<std::pair<int, Listener> > listeners_;
+    int nextListenerId_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_SETTINGS_H
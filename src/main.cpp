@@ -2,18 +2,37 @@
 #include "modules/terminal.h"
 #include "modules/editor.h"
 #include "modules/commands.h"
+#include "modules/batch.h"
+#include "modules/keynotation.h"
 #include "config/config.h"
+#include "utils/startuptime.h"
 #include <iostream>
 #include <stdexcept>
 #include <string>
 #include <functional> // Added as safeguard
+#include <csignal>
+#include <unistd.h>
 
 namespace cvim {
 
 // Version information
 const char* VERSION = "0.1.0";
 
+// Redraw at most once per frame (~60 Hz)
+static const int FRAME_BUDGET_MS = 16;
+// Poll interval while a key sequence or a save is pending
+static const int TICK_MS = 50;
+
 CVim::CVim(int argc, char** argv) {
+    // Needed before anything else starts, so not left to processArguments
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--startuptime") {
+            StartupTrace::start(argv[i + 1]);
+            StartupTrace::mark("--- CVIM STARTING ---");
+            break;
+        }
+    }
+    
     try {
         if (!initialize()) {
             std::cerr << "Failed to initialize application" << std::endl;
@@ -44,19 +63,34 @@ CVim::~CVim() {
 }
 
 bool CVim::initialize() {
-    // Load configuration first
-    if (!config_.load()) {
-        std::cerr << "Warning: Failed to load configuration, using defaults" << std::endl;
-        // Continue with defaults
-    }
+    // The config file is only read after the first frame (see run()); until
+    // then the defaults apply
     
     // Initialize terminal
     if (!terminal_.initialize()) {
         return false;
     }
+    StartupTrace::mark("terminal");
+
+    // Signals go through the reactor; block them before the editor starts
+    // any worker thread, so the threads inherit the mask
+    if (!reactor_.initialize() ||
+        !reactor_.addSignal(SIGWINCH, [this]() {
+            terminal_.handleResize();
+            dirty_ = true;
+        })) {
+        return false;
+    }
+    StartupTrace::mark("event loop");
 
     // Initialize editor with terminal and config references
     editor_.initialize(&terminal_, &config_);
+    StartupTrace::mark("editor");
+    
+    if (!setupEventSources()) {
+        return false;
+    }
+    StartupTrace::mark("event sources");
     
     // Set application as running
     running_ = true;
@@ -80,14 +114,30 @@ void CVim::processArguments(int argc, char** argv) {
             exit(0);
         }
         else if (arg == "--config" || arg == "-c") {
-            // Load specific config file
+            // Use a specific config file; it is read after the first frame
             if (i + 1 < argc) {
-                config_.load(argv[++i]);
+                config_.setConfigPath(argv[++i]);
             } else {
                 std::cerr << "Error: --config option requires a file path" << std::endl;
                 exit(1);
             }
         }
+        else if (arg == "--startuptime") {
+            // Already handled in the constructor
+            ++i;
+        }
+        else if (arg == "--record") {
+            if (i + 1 < argc) {
+                record_.open(argv[++i]);
+                if (!record_) {
+                    std::cerr << "Error: cannot write " << argv[i] << std::endl;
+                    exit(1);
+                }
+            } else {
+                std::cerr << "Error: --record option requires a file path" << std::endl;
+                exit(1);
+            }
+        }
         else {
             // Treat as file path
             filePaths.push_back(arg);
@@ -97,6 +147,7 @@ void CVim::processArguments(int argc, char** argv) {
     if (!filePaths.empty()) {
         openInitialFiles(filePaths);
     }
+    StartupTrace::mark("open files");
 }
 
 void CVim::openInitialFiles(const std::vector<std::string>& filePaths) {
@@ -114,6 +165,13 @@ void CVim::showHelp() {
               << "  -h, --help          Show this help message and exit\n"
               << "  -v, --version       Show version information and exit\n"
               << "  -c, --config FILE   Use specified config file\n"
+              << "  --startuptime FILE  Append startup timings to FILE\n"
+              << "  --record FILE       Write every key typed to FILE, for replays\n"
+              << "\n"
+              << "Batch mode: cvim -es [-c CMD ...] [-j N] [--config FILE] file ...\n"
+              << "  -es                 Apply ex commands to every file without a terminal\n"
+              << "  -c CMD, +CMD        Ex command to run (default: read from stdin)\n"
+              << "  -j, --jobs N        Files processed in parallel (default: one per CPU)\n"
               << std::endl;
 }
 
@@ -123,16 +181,101 @@ void CVim::showVersion() {
     std::cout << "Licensed under the MIT License" << std::endl;
 }
 
-int CVim::run() {
+bool CVim::setupEventSources() {
+    if (!reactor_.addReader(STDIN_FILENO, [this]() { readInput(); })) {
+        return false;
+    }
+    
+    // Files changed by other programs
+    int watchFd = editor_.getWatchFd();
+    if (watchFd >= 0) {
+        reactor_.addReader(watchFd, [this]() {
+            if (editor_.handleFileChanges()) dirty_ = true;
+        });
+    }
+    
+    // Worker threads poke this when they finish
+    int wakeupFd = reactor_.addWakeup([this]() {
+        if (editor_.processBackgroundTasks()) dirty_ = true;
+    });
+    if (wakeupFd < 0) {
+        return false;
+    }
+    editor_.setWakeup([wakeupFd]() { Reactor::wake(wakeupFd); });
+    
+    // Key sequence timeouts; only armed while something is pending
+    tickTimer_ = reactor_.addTimer([this]() {
+        if (editor_.processBackgroundTasks()) dirty_ = true;
+    });
+    return tickTimer_ >= 0;
+}
+
+void CVim::readInput() {
+    // Take everything that has arrived (e.g. a paste) before redrawing
     while (running_) {
-        // Render current editor state
-        terminal_.render(editor_.getViewData());
-        
-        // Get user input
         KeyInput input = terminal_.getInput();
+        if (input.key == Key::UNKNOWN && input.character == 0) break;
         
-        // Process the input
+        if (!inputPending_ && editor_.isShowingPerf()) {
+            inputTime_ = std::chrono::steady_clock::now();
+            inputPending_ = true;
+        }
+        if (record_.is_open()) {
+            // One line per command or inserted line keeps the script readable
+            record_ << formatKey(input);
+            if (input.key == Key::ENTER) record_ << '\n';
+        }
         editor_.handleInput(input);
+        dirty_ = true;
+        if (editor_.shouldQuit()) {
+            running_ = false;
+        }
+    }
+}
+
+int CVim::run() {
+    while (running_) {
+        int timeout = -1;
+        if (dirty_) {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            int elapsed = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRender_).count());
+            if (elapsed >= FRAME_BUDGET_MS) {
+                if (editor_.isShowingPerf()) {
+                    long long bytes = terminal_.getBytesWritten();
+                    terminal_.render(editor_.getViewData());
+                    std::chrono::steady_clock::time_point painted = std::chrono::steady_clock::now();
+                    long long latency = inputPending_
+                        ? std::chrono::duration_cast<std::chrono::nanoseconds>(painted - inputTime_).count() : -1;
+                    editor_.recordFrame(latency,
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(painted - now).count(),
+                        terminal_.getBytesWritten() - bytes);
+                    inputPending_ = false;
+                } else {
+                    terminal_.render(editor_.getViewData());
+                }
+                lastRender_ = now;
+                dirty_ = false;
+                
+                // Startup ends with the first frame; the rest follows it
+                if (!started_) {
+                    StartupTrace::mark("first frame");
+                    editor_.finishStartup();
+                    StartupTrace::finish();
+                    started_ = true;
+                    dirty_ = true;
+                }
+            } else {
+                timeout = FRAME_BUDGET_MS - elapsed;
+            }
+        }
+        
+        if (editor_.hasPendingWork() && !reactor_.isTimerArmed(tickTimer_)) {
+            reactor_.armTimer(tickTimer_, TICK_MS);
+        }
+        
+        // Sleep until input, a signal, a timer or a worker wakes us
+        reactor_.poll(timeout);
         
         // Check if we should exit
         if (editor_.shouldQuit()) {
@@ -159,6 +302,17 @@ void CVim::shutdown() {
 } // namespace cvim
 
 int main(int argc, char** argv) {
+    // Batch mode never touches the terminal
+    if (cvim::BatchRunner::isRequested(argc, argv)) {
+        cvim::BatchRunner batch;
+        std::string error;
+        if (!batch.parseArguments(argc, argv, error)) {
+            std::cerr << "cvim: " << error << std::endl;
+            return 2;
+        }
+        return batch.run();
+    }
+    
     cvim::CVim app(argc, argv);
     return app.run();
 }
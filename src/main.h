@@ -3,7 +3,10 @@
 
 #include <string>
 #include <vector>
+#include <chrono>
+#include <fstream>
 #include "modules/editor.h"
+#include "modules/reactor.h"
 #include "modules/terminal.h"
 #include "config/config.h"
 
@@ -23,11 +26,28 @@ private:
     void showHelp();
     void showVersion();
     void shutdown();
+    bool setupEventSources();
+    void readInput();
 
     Terminal terminal_;
+    // Declared before the editor so worker wakeups outlive it
+    Reactor reactor_;
     Editor editor_;
     Config config_;
     bool running_ = false;
+
+    // Redraws are coalesced: input only marks the screen dirty
+    bool dirty_ = true;
+    bool started_ = false;  // finishStartup() has run
+    std::chrono::steady_clock::time_point lastRender_;
+    int tickTimer_ = -1;
+    
+    // :set showperf: arrival of the first key not yet on screen
+    bool inputPending_ = false;
+    std::chrono::steady_clock::time_point inputTime_;
+    
+    // --record: every key typed, in <> notation, for replaying later
+    std::ofstream record_;
 };
 
 } // namespace cvim
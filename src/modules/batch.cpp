@@ -0,0 +1,186 @@
+#include "batch.h"
+#include "editor.h"
+#include "commands.h"
+#include "../config/config.h"
+#include "../config/settings.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace cvim {
+
+BatchRunner::BatchRunner() : jobs_(0), next_(0), lines_(0), modified_(0), failed_(0) {}
+
+BatchRunner::~BatchRunner() {}
+
+bool BatchRunner::isRequested(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "-es") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BatchRunner::parseArguments(int argc, char** argv, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-es") {
+            continue;
+        } else if (arg == "-c") {
+            // As in vim; the interactive -c (--config) does not apply here
+            if (i + 1 >= argc) {
+                error = "-c requires a command";
+                return false;
+            }
+            commands_.push_back(argv[++i]);
+        } else if (arg.size() > 1 && arg[0] == '+') {
+            commands_.push_back(arg.substr(1));
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                error = arg + " requires a positive number";
+                return false;
+            }
+            jobs_ = atoi(argv[++i]);
+        } else if (arg == "--config") {
+            if (i + 1 >= argc) {
+                error = "--config requires a file path";
+                return false;
+            }
+            configPath_ = argv[++i];
+        } else if (arg == "--") {
+            files_.insert(files_.end(), argv + i + 1, argv + argc);
+            break;
+        } else {
+            files_.push_back(arg);
+        }
+    }
+
+    // An ex script on stdin: cvim -es *.txt < edits.vim
+    if (commands_.empty() && !isatty(STDIN_FILENO)) {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty() && line[0] != '"') {
+                commands_.push_back(line);
+            }
+        }
+    }
+
+    if (commands_.empty()) {
+        error = "no commands given (use -c or a script on stdin)";
+        return false;
+    }
+    if (files_.empty()) {
+        error = "no files given";
+        return false;
+    }
+    return true;
+}
+
+int BatchRunner::run() {
+    // The user's ~/.cvimrc is not read, so scripts behave the same everywhere
+    Config config;
+    if (!configPath_.empty() && !config.load(configPath_)) {
+        std::cerr << "cvim: " << (config.getError().empty() ? "cannot read " + configPath_ : config.getError())
+                  << std::endl;
+        return 1;
+    }
+
+    int workers = jobs_ > 0 ? jobs_ : config.getSettings().getInteger(SETTING_THREADS);
+    if (workers <= 0) {
+        workers = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    workers = std::max(1, std::min(workers, static_cast<int>(files_.size())));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers; ++i) {
+        threads.push_back(std::thread(&BatchRunner::work, this, std::cref(config)));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = seconds > 0 ? 1.0 / seconds : 0;
+    std::cerr << "cvim: " << files_.size() << " files, " << lines_ << " lines, "
+              << modified_ << " modified, " << failed_ << " failed in "
+              << std::fixed << std::setprecision(3) << seconds << "s ("
+              << std::setprecision(0) << files_.size() * rate << " files/s, "
+              << lines_ * rate << " lines/s, " << workers
+              << (workers == 1 ? " worker)" : " workers)") << std::endl;
+    return failed_ > 0 ? 1 : 0;
+}
+
+void BatchRunner::work(const Config& shared) {
+    // Everything but the file list and the totals is private to the worker
+    Config config = shared;
+    Editor editor;
+    editor.initialize(nullptr, &config);
+    CommandProcessor commands(&editor);
+
+    size_t lines = 0;
+    size_t modified = 0;
+    size_t failed = 0;
+    for (size_t index = next_++; index < files_.size(); index = next_++) {
+        std::string error;
+        size_t fileLines = 0;
+        bool fileModified = false;
+        if (!processFile(editor, commands, files_[index], error, fileLines, fileModified)) {
+            ++failed;
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::cerr << "cvim: " << files_[index] << ": " << error << std::endl;
+        }
+        lines += fileLines;
+        if (fileModified) ++modified;
+    }
+    editor.cleanup();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    lines_ += lines;
+    modified_ += modified;
+    failed_ += failed;
+}
+
+bool BatchRunner::processFile(Editor& editor, CommandProcessor& commands, const std::string& filePath,
+                              std::string& error, size_t& lines, bool& modified) {
+    if (!editor.openFile(filePath)) {
+        error = "cannot open file";
+        return false;
+    }
+    std::shared_ptr<Buffer> buffer = editor.getCurrentBuffer();
+    unsigned long loadedTick = buffer->getChangeTick();
+    editor.cancelQuit();
+    editor.setStatusMessage("");
+
+    bool ok = true;
+    for (size_t i = 0; i < commands_.size() && !editor.shouldQuit(); ++i) {
+        if (!commands.executeCommand(commands_[i])) {
+            const std::string& message = editor.getStatusMessage();
+            error = commands_[i] + ": " + (message.empty() ? "not an editor command" : message);
+            ok = false;
+            break;
+        }
+    }
+
+    // Unless the script quit (:wq, :x, :q!), the result is written like :x;
+    // after an error the file is left alone
+    if (ok && !editor.shouldQuit() && buffer->isModified() && !editor.saveFile()) {
+        error = "write failed";
+        ok = false;
+    }
+
+    lines = buffer->getLines().size();
+    modified = buffer->getChangeTick() != loadedTick;
+    editor.closeBuffer();
+    return ok;
+}
+
+} // namespace cvim
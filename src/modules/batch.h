@@ -0,0 +1,55 @@
+#ifndef CVIM_BATCH_H
+#define CVIM_BATCH_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstddef>
+
+namespace cvim {
+
+class Config;
+class Editor;
+class CommandProcessor;
+
+// Headless ex mode (cvim -es): applies the same ex commands to many files
+// with no terminal at all. Each worker thread owns an Editor and works on
+// one buffer at a time; throughput is reported on stderr at the end.
+class BatchRunner {
+public:
+    BatchRunner();
+    ~BatchRunner();
+
+    // True if the command line asks for batch mode
+    static bool isRequested(int argc, char** argv);
+
+    // -es, -c CMD / +CMD (repeatable), -j N, --config FILE and files.
+    // Without -c the commands are read from stdin, one per line.
+    bool parseArguments(int argc, char** argv, std::string& error);
+
+    // Process every file; returns the exit status (1 if any file failed)
+    int run();
+
+private:
+    void work(const Config& config);
+    // Run the commands on one file and write it back if they changed it
+    // without quitting. false with a message if a command failed.
+    bool processFile(Editor& editor, CommandProcessor& commands, const std::string& filePath,
+                     std::string& error, size_t& lines, bool& modified);
+
+    std::vector<std::string> commands_;
+    std::vector<std::string> files_;
+    std::string configPath_;
+    int jobs_;  // 0: the threads setting
+
+    std::atomic<size_t> next_;  // index of the next file to take
+    std::mutex mutex_;          // guards the totals and stderr
+    size_t lines_;
+    size_t modified_;
+    size_t failed_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_BATCH_H
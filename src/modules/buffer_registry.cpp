@@ -0,0 +1,112 @@
+#include "buffer_registry.h"
+#include "editor.h"
+#include <climits>
+#include <cstdlib>
+#include <sys/stat.h>
+
+namespace cvim {
+
+BufferRegistry::BufferRegistry() {}
+
+BufferRegistry::~BufferRegistry() {}
+
+std::shared_ptr<Buffer> BufferRegistry::open(const std::string& filePath, bool& created) {
+    created = false;
+
+    std::shared_ptr<Buffer> buffer = find(filePath);
+    if (buffer) {
+        return buffer;
+    }
+
+    FileKey key;
+    if (!makeKey(filePath, key)) {
+        return nullptr;
+    }
+
+    // Set the path before loading so the file is read exactly once
+    buffer = std::make_shared<Buffer>();
+    buffer->setFilePath(filePath);
+    if (!buffer->load()) {
+        return nullptr;
+    }
+
+    add(key, canonicalPath(filePath), buffer);
+    created = true;
+    return buffer;
+}
+
+std::shared_ptr<Buffer> BufferRegistry::find(const std::string& filePath) {
+    FileKey key;
+    if (!makeKey(filePath, key)) {
+        return nullptr;
+    }
+
+    std::map<FileKey, std::weak_ptr<Buffer> >::iterator byInode = byInode_.find(key);
+    if (byInode != byInode_.end()) {
+        // A buffer written under another name no longer owns this inode
+        std::shared_ptr<Buffer> buffer = byInode->second.lock();
+        FileKey current;
+        if (buffer && makeKey(buffer->getFilePath(), current) &&
+            !(current < key) && !(key < current)) {
+            return buffer;
+        }
+        byInode_.erase(byInode);
+    }
+
+    // Saving renames a new file into place, so the inode may have moved on
+    std::string canonical = canonicalPath(filePath);
+    std::map<std::string, std::weak_ptr<Buffer> >::iterator byPath = byPath_.find(canonical);
+    if (byPath != byPath_.end()) {
+        std::shared_ptr<Buffer> buffer = byPath->second.lock();
+        if (buffer && canonicalPath(buffer->getFilePath()) == canonical) {
+            byInode_[key] = buffer;
+            return buffer;
+        }
+        byPath_.erase(byPath);
+    }
+
+    return nullptr;
+}
+
+void BufferRegistry::track(const std::shared_ptr<Buffer>& buffer) {
+    FileKey key;
+    if (buffer && makeKey(buffer->getFilePath(), key)) {
+        add(key, canonicalPath(buffer->getFilePath()), buffer);
+    }
+}
+
+int BufferRegistry::getBufferCount() const {
+    int count = 0;
+    for (std::map<std::string, std::weak_ptr<Buffer> >::const_iterator it = byPath_.begin();
+         it != byPath_.end(); ++it) {
+        if (!it->second.expired()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool BufferRegistry::makeKey(const std::string& filePath, FileKey& key) {
+    struct stat st;
+    if (stat(filePath.c_str(), &st) != 0) {
+        return false;
+    }
+    key.device = st.st_dev;
+    key.inode = st.st_ino;
+    return true;
+}
+
+std::string BufferRegistry::canonicalPath(const std::string& filePath) {
+    char resolved[PATH_MAX];
+    if (realpath(filePath.c_str(), resolved) != nullptr) {
+        return resolved;
+    }
+    return normalizePath(filePath);
+}
+
+void BufferRegistry::add(const FileKey& key, const std::string& canonical, const std::shared_ptr<Buffer>& buffer) {
+    byInode_[key] = buffer;
+    byPath_[canonical] = buffer;
+}
+
+} // namespace cvim
@@ -0,0 +1,55 @@
+#ifndef CVIM_BUFFER_REGISTRY_H
+#define CVIM_BUFFER_REGISTRY_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <sys/types.h>
+
+namespace cvim {
+
+class Buffer;
+
+// Tracks the live buffer for every open file so the same file is read once
+// and shared between tabs. Files are identified by device and inode; the
+// canonical path is kept as well because an atomic save gives the file a
+// new inode.
+class BufferRegistry {
+public:
+    BufferRegistry();
+    ~BufferRegistry();
+
+    // Return the live buffer for filePath, loading it if it is not open yet.
+    // created is set when the file was read from disk by this call.
+    std::shared_ptr<Buffer> open(const std::string& filePath, bool& created);
+
+    // The live buffer for filePath, or null
+    std::shared_ptr<Buffer> find(const std::string& filePath);
+
+    // (Re-)register a buffer under its current path, e.g. after :w newname
+    void track(const std::shared_ptr<Buffer>& buffer);
+
+    int getBufferCount() const;
+
+private:
+    struct FileKey {
+        dev_t device;
+        ino_t inode;
+
+        bool operator<(const FileKey& other) const {
+            return device < other.device || (device == other.device && inode < other.inode);
+        }
+    };
+
+    static bool makeKey(const std::string& filePath, FileKey& key);
+    static std::string canonicalPath(const std::string& filePath);
+
+    void add(const FileKey& key, const std::string& canonical, const std::shared_ptr<Buffer>& buffer);
+
+    std::map<FileKey, std::weak_ptr<Buffer> > byInode_;
+    std::map<std::string, std::weak_ptr<Buffer> > byPath_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_BUFFER_REGISTRY_H
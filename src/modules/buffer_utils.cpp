@@ -1,14 +1,34 @@
 #include "buffer_utils.h"
+#include "../utils/profiler.h"
+#include "../utils/unicode.h"
+#include <algorithm>
 
 namespace cvim {
 
+namespace {
+
+// Clamp a position into the buffer; columns may sit one past the line end
+Position clampPosition(const Buffer& buffer, Position pos) {
+    const auto& lines = buffer.getLines();
+    int maxRow = static_cast<int>(lines.size()) - 1;
+    pos.row = std::max(0, std::min(pos.row, maxRow));
+    pos.col = std::max(0, std::min(pos.col, static_cast<int>(lines[pos.row].size())));
+    return pos;
+}
+
+bool positionBefore(const Position& a, const Position& b) {
+    return a.row < b.row || (a.row == b.row && a.col < b.col);
+}
+
+} // namespace
+
 void BufferUtils::insertCharAtPosition(Buffer& buffer, int row, int col, char c) {
-    auto& lines = const_cast<std::vector<std::string>&>(buffer.getLines());
-    
-    if (row < 0 || row >= static_cast<int>(lines.size())) {
+    PROFILE_SCOPE("BufferUtils::insertCharAtPosition");
+    if (row < 0 || row >= static_cast<int>(buffer.getLines().size())) {
         return;
     }
     
+    auto& lines = buffer.getMutableLines();
     std::string& line = lines[row];
     if (col < 0 || col > static_cast<int>(line.size())) {
         return;
@@ -16,15 +36,16 @@ void BufferUtils::insertCharAtPosition(Buffer& buffer, int row, int col, char c)
     
     line.insert(col, 1, c);
     buffer.setModified(true);
+    buffer.noteEdit(EDIT_INSERT_CHAR, row, col, std::string(1, c));
 }
 
 void BufferUtils::deleteCharAtPosition(Buffer& buffer, int row, int col) {
-    auto& lines = const_cast<std::vector<std::string>&>(buffer.getLines());
-    
-    if (row < 0 || row >= static_cast<int>(lines.size())) {
+    PROFILE_SCOPE("BufferUtils::deleteCharAtPosition");
+    if (row < 0 || row >= static_cast<int>(buffer.getLines().size())) {
         return;
     }
     
+    auto& lines = buffer.getMutableLines();
     std::string& line = lines[row];
     if (col < 0 || col >= static_cast<int>(line.size())) {
         return;
@@ -32,15 +53,16 @@ void BufferUtils::deleteCharAtPosition(Buffer& buffer, int row, int col) {
     
     line.erase(col, 1);
     buffer.setModified(true);
+    buffer.noteEdit(EDIT_DELETE_CHAR, row, col);
 }
 
 void BufferUtils::insertLineBreak(Buffer& buffer, int row, int col) {
-    auto& lines = const_cast<std::vector<std::string>&>(buffer.getLines());
-    
-    if (row < 0 || row >= static_cast<int>(lines.size())) {
+    PROFILE_SCOPE("BufferUtils::insertLineBreak");
+    if (row < 0 || row >= static_cast<int>(buffer.getLines().size())) {
         return;
     }
     
+    auto& lines = buffer.getMutableLines();
     std::string& line = lines[row];
     if (col < 0 || col > static_cast<int>(line.size())) {
         return;
@@ -54,21 +76,173 @@ void BufferUtils::insertLineBreak(Buffer& buffer, int row, int col) {
     // Insert the new line after the current one
     lines.insert(lines.begin() + row + 1, newLine);
     buffer.setModified(true);
+    buffer.noteEdit(EDIT_LINE_BREAK, row, col);
 }
 
 void BufferUtils::joinLines(Buffer& buffer, int line) {
-    auto& lines = const_cast<std::vector<std::string>&>(buffer.getLines());
-    
-    if (line < 0 || line >= static_cast<int>(lines.size()) - 1) {
+    PROFILE_SCOPE("BufferUtils::joinLines");
+    if (line < 0 || line >= static_cast<int>(buffer.getLines().size()) - 1) {
         return;
     }
     
+    auto& lines = buffer.getMutableLines();
+    
     // Append the next line to the current line
     lines[line] += lines[line + 1];
     
     // Remove the next line
     lines.erase(lines.begin() + line + 1);
     buffer.setModified(true);
+    buffer.noteEdit(EDIT_JOIN_LINES, line, 0);
+}
+
+void BufferUtils::insertText(Buffer& buffer, int row, int col, const std::string& text) {
+    PROFILE_SCOPE("BufferUtils::insertText");
+    if (text.empty() || row < 0 || row >= static_cast<int>(buffer.getLines().size())) {
+        return;
+    }
+    
+    auto& lines = buffer.getMutableLines();
+    std::string& line = lines[row];
+    if (col < 0 || col > static_cast<int>(line.size())) {
+        return;
+    }
+    
+    std::vector<std::string> pieces = splitLines(text);
+    std::string tail = line.substr(col);
+    line.resize(col);
+    line += pieces[0];
+    if (pieces.size() == 1) {
+        line += tail;
+    } else {
+        pieces.back() += tail;
+        lines.insert(lines.begin() + row + 1, pieces.begin() + 1, pieces.end());
+    }
+    buffer.setModified(true);
+    buffer.noteEdit(EDIT_INSERT_TEXT, row, col, text);
+}
+
+void BufferUtils::deleteText(Buffer& buffer, const Range& range) {
+    PROFILE_SCOPE("BufferUtils::deleteText");
+    if (buffer.getLines().empty()) {
+        return;
+    }
+    
+    Position start = clampPosition(buffer, range.start);
+    Position end = clampPosition(buffer, range.end);
+    if (positionBefore(end, start)) {
+        std::swap(start, end);
+    }
+    if (start.row == end.row && start.col == end.col) {
+        return;
+    }
+    
+    Range clamped = { start, end };
+    std::string deleted = getText(buffer, clamped);
+    
+    auto& lines = buffer.getMutableLines();
+    if (start.row == end.row) {
+        lines[start.row].erase(start.col, end.col - start.col);
+    } else {
+        lines[start.row].resize(start.col);
+        lines[start.row] += lines[end.row].substr(end.col);
+        lines.erase(lines.begin() + start.row + 1, lines.begin() + end.row + 1);
+    }
+    buffer.setModified(true);
+    buffer.noteEdit(EDIT_DELETE_TEXT, start.row, start.col, deleted);
+}
+
+std::string BufferUtils::getText(const Buffer& buffer, const Range& range) {
+    const auto& lines = buffer.getLines();
+    if (lines.empty()) {
+        return std::string();
+    }
+    
+    Position start = clampPosition(buffer, range.start);
+    Position end = clampPosition(buffer, range.end);
+    if (positionBefore(end, start)) {
+        std::swap(start, end);
+    }
+    
+    if (start.row == end.row) {
+        return lines[start.row].substr(start.col, end.col - start.col);
+    }
+    
+    std::string text = lines[start.row].substr(start.col);
+    for (int row = start.row + 1; row < end.row; ++row) {
+        text += '\n';
+        text += lines[row];
+    }
+    text += '\n';
+    text += lines[end.row].substr(0, end.col);
+    return text;
+}
+
+void BufferUtils::insertLines(Buffer& buffer, int row, const std::vector<std::string>& newLines) {
+    PROFILE_SCOPE("BufferUtils::insertLines");
+    if (newLines.empty() || row < 0 || row > static_cast<int>(buffer.getLines().size())) {
+        return;
+    }
+    
+    auto& lines = buffer.getMutableLines();
+    lines.insert(lines.begin() + row, newLines.begin(), newLines.end());
+    buffer.setModified(true);
+    buffer.noteEdit(EDIT_INSERT_LINES, row, 0, join(newLines, "\n"));
+}
+
+void BufferUtils::deleteLines(Buffer& buffer, int row, int count) {
+    PROFILE_SCOPE("BufferUtils::deleteLines");
+    int lineCount = static_cast<int>(buffer.getLines().size());
+    if (row < 0 || row >= lineCount || count <= 0) {
+        return;
+    }
+    count = std::min(count, lineCount - row);
+    
+    // One erase, however many lines
+    auto& lines = buffer.getMutableLines();
+    lines.erase(lines.begin() + row, lines.begin() + row + count);
+    if (lines.empty()) {
+        lines.push_back("");
+    }
+    buffer.setModified(true);
+    buffer.noteEdit(EDIT_DELETE_LINES, row, count);
+}
+
+void BufferUtils::replaceLines(Buffer& buffer, int row, int count, const std::vector<std::string>& newLines) {
+    PROFILE_SCOPE("BufferUtils::replaceLines");
+    int lineCount = static_cast<int>(buffer.getLines().size());
+    if (row < 0 || row >= lineCount || count <= 0) {
+        return;
+    }
+    if (newLines.empty()) {
+        deleteLines(buffer, row, count);
+        return;
+    }
+    count = std::min(count, lineCount - row);
+    
+    // Overwrite the lines both sides share, then grow or shrink once
+    auto& lines = buffer.getMutableLines();
+    int shared = std::min(count, static_cast<int>(newLines.size()));
+    std::copy(newLines.begin(), newLines.begin() + shared, lines.begin() + row);
+    if (count > shared) {
+        lines.erase(lines.begin() + row + shared, lines.begin() + row + count);
+    } else {
+        lines.insert(lines.begin() + row + shared, newLines.begin() + shared, newLines.end());
+    }
+    buffer.setModified(true);
+    buffer.noteEdit(EDIT_REPLACE_LINES, row, count, join(newLines, "\n"));
+}
+
+std::vector<std::string> BufferUtils::splitLines(const std::string& text) {
+    std::vector<std::string> pieces;
+    size_t start = 0;
+    size_t newline;
+    while ((newline = text.find('\n', start)) != std::string::npos) {
+        pieces.push_back(text.substr(start, newline - start));
+        start = newline + 1;
+    }
+    pieces.push_back(text.substr(start));
+    return pieces;
 }
 
 int BufferUtils::getLineLength(const Buffer& buffer, int line) {
@@ -80,6 +254,22 @@ int BufferUtils::getLineLength(const Buffer& buffer, int line) {
     return lines[line].length();
 }
 
+int BufferUtils::nextCharStart(const Buffer& buffer, int row, int col) {
+    const auto& lines = buffer.getLines();
+    if (row < 0 || row >= static_cast<int>(lines.size())) {
+        return 0;
+    }
+    return static_cast<int>(cvim::nextCharStart(lines[row], std::max(0, col)));
+}
+
+int BufferUtils::prevCharStart(const Buffer& buffer, int row, int col) {
+    const auto& lines = buffer.getLines();
+    if (row < 0 || row >= static_cast<int>(lines.size()) || col <= 0) {
+        return 0;
+    }
+    return static_cast<int>(cvim::prevCharStart(lines[row], col));
+}
+
 bool BufferUtils::isWordChar(char c) {
     // Word characters are alphanumeric or underscore
     return isalnum(c) || c == '_';
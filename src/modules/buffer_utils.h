@@ -12,7 +12,24 @@ public:
     static void deleteCharAtPosition(Buffer& buffer, int row, int col);
     static void insertLineBreak(Buffer& buffer, int row, int col);
     static void joinLines(Buffer& buffer, int line);
+    
+    // Bulk edits, so a counted command is one operation and one journal
+    // record. Ranges are charwise with an exclusive end.
+    static void insertText(Buffer& buffer, int row, int col, const std::string& text);
+    static void deleteText(Buffer& buffer, const Range& range);
+    static std::string getText(const Buffer& buffer, const Range& range);
+    static void insertLines(Buffer& buffer, int row, const std::vector<std::string>& newLines);
+    static void deleteLines(Buffer& buffer, int row, int count);
+    // count lines from row give way to newLines (any number) in one edit
+    static void replaceLines(Buffer& buffer, int row, int count, const std::vector<std::string>& newLines);
+    // Split on '\n', keeping empty pieces: "a\n" gives {"a", ""}
+    static std::vector<std::string> splitLines(const std::string& text);
+    
     static int getLineLength(const Buffer& buffer, int line);
+    // Byte column of the next or previous character on the line, stepping
+    // over whole UTF-8 sequences and combining marks (see unicode.h)
+    static int nextCharStart(const Buffer& buffer, int row, int col);
+    static int prevCharStart(const Buffer& buffer, int row, int col);
     static bool isWordChar(char c);
     static int findNextWordStart(const Buffer& buffer, int row, int col);
     static int findPrevWordStart(const Buffer& buffer, int row, int col);
@@ -1,17 +1,267 @@
 #include "commands.h"
 #include "editor.h"
+#include "buffer_utils.h"
+#include "motions.h"
+#include "../config/settings.h"
 #include "../utils/utils.h"
+#include "../utils/profiler.h"
 #include <sstream>
 #include <algorithm>
 #include <functional>
+#include <cctype>
 
 namespace cvim {
 
-CommandProcessor::CommandProcessor() : editor_(nullptr) {
+namespace {
+
+// A :s or :g pattern, translated from vim's (magic) syntax to ECMAScript.
+// literal holds the plain text to search for when nothing in the pattern
+// is special, which is much faster than std::regex.
+struct Pattern {
+    std::string regex;
+    std::string literal;
+    bool isLiteral;
+};
+
+// A :s replacement as a std::regex format string; literal as for Pattern
+struct Replacement {
+    std::string format;
+    std::string literal;
+    bool isLiteral;
+    bool hasNewline;  // \r splits the line
+};
+
+void appendLiteral(Pattern& pattern, char c) {
+    static const std::string special = "\\^$.|?*+()[]{}";
+    if (special.find(c) != std::string::npos) {
+        pattern.regex += '\\';
+    }
+    pattern.regex += c;
+    pattern.literal += c;
+}
+
+void appendSpecial(Pattern& pattern, const std::string& regex) {
+    pattern.regex += regex;
+    pattern.isLiteral = false;
+}
+
+// The bracket expression opening at source[start], rewritten for
+// ECMAScript into out; returns the index of its closing ], or npos if it
+// never closes. [:class:] is kept whole, [=x=] and [.x.] become x, and a
+// ] right after the [ or [^ is a member, which ECMAScript needs escaped.
+size_t translateBracket(const std::string& source, size_t start, std::string& out) {
+    out = "[";
+    size_t i = start + 1;
+    if (i < source.size() && source[i] == '^') {
+        out += '^';
+        ++i;
+    }
+    if (i < source.size() && source[i] == ']') {
+        out += "\\]";
+        ++i;
+    }
+    while (i < source.size()) {
+        char c = source[i];
+        if (c == ']') {
+            out += ']';
+            return i;
+        }
+        if (c == '[' && i + 1 < source.size() &&
+            (source[i + 1] == ':' || source[i + 1] == '=' || source[i + 1] == '.')) {
+            const char close[] = { source[i + 1], ']', '\0' };
+            size_t found = source.find(close, i + 2);
+            if (found == std::string::npos) return std::string::npos;
+            if (source[i + 1] != ':' && found == i + 3) {
+                // Like vim, one character; std::regex rejects most of these
+                // by name, so write the character itself
+                if (std::string("]\\^-[").find(source[i + 2]) != std::string::npos) out += '\\';
+                out += source[i + 2];
+            } else {
+                out.append(source, i, found + 2 - i);
+            }
+            i = found + 2;
+            continue;
+        }
+        if (c == '\\' && i + 1 < source.size()) {
+            out.append(source, i, 2);
+            i += 2;
+            continue;
+        }
+        out += c;
+        ++i;
+    }
+    return std::string::npos;
+}
+
+Pattern translatePattern(const std::string& source) {
+    Pattern pattern;
+    pattern.isLiteral = true;
+    bool inBrace = false;
+    
+    for (size_t i = 0; i < source.size(); ++i) {
+        char c = source[i];
+        if (c == '\\' && i + 1 < source.size()) {
+            char next = source[++i];
+            switch (next) {
+                case '(': case ')': case '|': case '+': case '?':
+                    appendSpecial(pattern, std::string(1, next));
+                    break;
+                case '{':
+                    appendSpecial(pattern, "{");
+                    inBrace = true;
+                    break;
+                case '=':
+                    appendSpecial(pattern, "?");
+                    break;
+                case '<': case '>':
+                    appendSpecial(pattern, "\\b");
+                    break;
+                case 's': case 'S': case 'd': case 'D': case 'w': case 'W':
+                    appendSpecial(pattern, std::string("\\") + next);
+                    break;
+                case 't':
+                    appendLiteral(pattern, '\t');
+                    break;
+                default:
+                    // \/, \., \*, \\ and friends
+                    appendLiteral(pattern, next);
+                    break;
+            }
+        } else if (c == '[') {
+            // Bracket expression; without a closing ] the [ is literal
+            std::string bracket;
+            size_t end = translateBracket(source, i, bracket);
+            if (end != std::string::npos) {
+                appendSpecial(pattern, bracket);
+                i = end;
+            } else {
+                appendLiteral(pattern, c);
+            }
+        } else if (c == '.' || c == '*') {
+            appendSpecial(pattern, std::string(1, c));
+        } else if (c == '^' && i == 0) {
+            appendSpecial(pattern, "^");
+        } else if (c == '$' && i + 1 == source.size()) {
+            appendSpecial(pattern, "$");
+        } else if (c == '}' && inBrace) {
+            appendSpecial(pattern, "}");
+            inBrace = false;
+        } else {
+            appendLiteral(pattern, c);
+        }
+    }
+    return pattern;
+}
+
+void appendLiteral(Replacement& replacement, char c) {
+    replacement.format += c == '$' ? std::string("$$") : std::string(1, c);
+    replacement.literal += c;
+}
+
+Replacement translateReplacement(const std::string& source) {
+    Replacement replacement;
+    replacement.isLiteral = true;
+    replacement.hasNewline = false;
+    
+    for (size_t i = 0; i < source.size(); ++i) {
+        char c = source[i];
+        if (c == '\\' && i + 1 < source.size()) {
+            char next = source[++i];
+            if (next >= '0' && next <= '9') {
+                replacement.format += next == '0' ? std::string("$&") : std::string("$") + next;
+                replacement.isLiteral = false;
+            } else if (next == 'r' || next == 'n') {
+                appendLiteral(replacement, '\n');
+                replacement.hasNewline = true;
+            } else if (next == 't') {
+                appendLiteral(replacement, '\t');
+            } else {
+                appendLiteral(replacement, next);
+            }
+        } else if (c == '&') {
+            replacement.format += "$&";
+            replacement.isLiteral = false;
+        } else {
+            appendLiteral(replacement, c);
+        }
+    }
+    return replacement;
+}
+
+// Read up to the next unescaped delimiter (or the end) and step past it.
+// An escaped delimiter stands for itself; other escapes are kept.
+std::string readDelimited(const std::string& text, size_t& pos, char delimiter) {
+    std::string piece;
+    while (pos < text.size() && text[pos] != delimiter) {
+        if (text[pos] == '\\' && pos + 1 < text.size()) {
+            if (text[pos + 1] != delimiter) {
+                piece += '\\';
+            }
+            ++pos;
+        }
+        piece += text[pos++];
+    }
+    if (pos < text.size()) {
+        ++pos;
+    }
+    return piece;
+}
+
+bool isPatternDelimiter(char c) {
+    return !std::isalnum(static_cast<unsigned char>(c)) && c != '\\' && c != '"' &&
+           c != '|' && c != ' ';
+}
+
+// Replacements made in line, with the new text in result
+int replaceLiteral(const std::string& line, const std::string& literal,
+                   const std::string& replacement, bool global, std::string& result) {
+    size_t found = line.find(literal);
+    if (found == std::string::npos) return 0;
+    
+    result.clear();
+    size_t copied = 0;
+    int count = 0;
+    while (found != std::string::npos) {
+        result.append(line, copied, found - copied);
+        result += replacement;
+        copied = found + literal.size();
+        ++count;
+        if (!global) break;
+        found = line.find(literal, copied);
+    }
+    result.append(line, copied, std::string::npos);
+    return count;
+}
+
+int replaceRegex(const std::string& line, const std::regex& regex,
+                 const std::string& format, bool global, std::string& result) {
+    std::sregex_iterator match(line.begin(), line.end(), regex);
+    std::sregex_iterator end;
+    if (match == end) return 0;
+    
+    result.clear();
+    std::string::const_iterator copied = line.begin();
+    int count = 0;
+    for (; match != end; ++match) {
+        result.append(copied, (*match)[0].first);
+        result += match->format(format);
+        copied = (*match)[0].second;
+        ++count;
+        if (!global) break;
+    }
+    result.append(copied, line.end());
+    return count;
+}
+
+} // namespace
+
+CommandProcessor::CommandProcessor()
+    : editor_(nullptr), regexIgnoreCase_(false), regexValid_(false), globalDepth_(0) {
     registerBuiltInCommands();
 }
 
-CommandProcessor::CommandProcessor(Editor* editor) : editor_(editor) {
+CommandProcessor::CommandProcessor(Editor* editor)
+    : editor_(editor), regexIgnoreCase_(false), regexValid_(false), globalDepth_(0) {
     registerBuiltInCommands();
 }
 
@@ -25,6 +275,8 @@ void CommandProcessor::registerBuiltInCommands() {
     // Use simpler syntax without lambdas for older compilers
     commands_["q"] = std::bind(&CommandProcessor::cmdQuit, this, std::placeholders::_1);
     commands_["quit"] = std::bind(&CommandProcessor::cmdQuit, this, std::placeholders::_1);
+    commands_["q!"] = std::bind(&CommandProcessor::cmdQuitForce, this, std::placeholders::_1);
+    commands_["quit!"] = std::bind(&CommandProcessor::cmdQuitForce, this, std::placeholders::_1);
     
     commands_["w"] = std::bind(&CommandProcessor::cmdWrite, this, std::placeholders::_1);
     commands_["write"] = std::bind(&CommandProcessor::cmdWrite, this, std::placeholders::_1);
@@ -45,11 +297,69 @@ void CommandProcessor::registerBuiltInCommands() {
     commands_["set"] = std::bind(&CommandProcessor::cmdSet, this, std::placeholders::_1);
     
     commands_["help"] = std::bind(&CommandProcessor::cmdHelp, this, std::placeholders::_1);
+    
+    commands_["buffers"] = std::bind(&CommandProcessor::cmdBuffers, this, std::placeholders::_1);
+    commands_["ls"] = std::bind(&CommandProcessor::cmdBuffers, this, std::placeholders::_1);
+    
+    commands_["jobs"] = std::bind(&CommandProcessor::cmdJobs, this, std::placeholders::_1);
+    
+    commands_["recover"] = std::bind(&CommandProcessor::cmdRecover, this, std::placeholders::_1);
+    commands_["dropswap"] = std::bind(&CommandProcessor::cmdDropSwap, this, std::placeholders::_1);
+
+    commands_["profile"] = std::bind(&CommandProcessor::cmdProfile, this, std::placeholders::_1);
 }
 
 bool CommandProcessor::executeCommand(const std::string& command) {
     if (command.empty()) return false;
     
+    // The range and the commands that take one are parsed here; everything
+    // else is split into words for its handler
+    size_t pos = command.find_first_not_of(" :");
+    if (pos == std::string::npos) return false;
+    if (editor_ && editor_->getCurrentBuffer()) {
+        int first;
+        int last;
+        bool given;
+        if (!parseRange(command, pos, first, last, given)) return false;
+        
+        size_t nameEnd = pos;
+        while (nameEnd < command.size() && std::isalpha(static_cast<unsigned char>(command[nameEnd]))) {
+            ++nameEnd;
+        }
+        std::string name = command.substr(pos, nameEnd - pos);
+        std::string rest = command.substr(nameEnd);
+        
+        if (name.empty() && trim(rest).empty()) {
+            return given ? cmdGoto(last) : false;
+        }
+        if (name == "s" || name == "substitute") {
+            return cmdSubstitute(first, last, rest);
+        }
+        if (name == "g" || name == "global" || name == "v" || name == "vglobal") {
+            bool invert = name[0] == 'v';
+            if (!invert && !rest.empty() && rest[0] == '!') {
+                invert = true;
+                rest.erase(0, 1);
+            }
+            if (!given) {
+                first = 0;
+                last = static_cast<int>(editor_->getCurrentBuffer()->getLines().size()) - 1;
+            }
+            return cmdGlobal(first, last, invert, rest);
+        }
+        if (name == "d" || name == "delete") {
+            if (!trim(rest).empty()) {
+                editor_->setStatusMessage("Trailing characters: " + rest);
+                return false;
+            }
+            return cmdDelete(first, last);
+        }
+        if (given) {
+            editor_->setStatusMessage("No range allowed");
+            return false;
+        }
+    }
+    
     std::vector<std::string> args = parseCommand(command);
     if (args.empty()) return false;
     
@@ -77,6 +387,291 @@ std::vector<std::string> CommandProcessor::getCompletions(const std::string& par
     return completions;
 }
 
+bool CommandProcessor::parseRange(const std::string& command, size_t& pos, int& first, int& last, bool& given) {
+    int lastLine = static_cast<int>(editor_->getCurrentBuffer()->getLines().size()) - 1;
+    int current = editor_->getCursor().getRow();
+    first = current;
+    last = current;
+    given = false;
+    
+    if (pos < command.size() && command[pos] == '%') {
+        ++pos;
+        first = 0;
+        last = lastLine;
+        given = true;
+    } else {
+        if (parseAddress(command, pos, first)) {
+            last = first;
+            given = true;
+        }
+        if (pos < command.size() && (command[pos] == ',' || command[pos] == ';')) {
+            // A missing address on either side is the cursor line
+            ++pos;
+            if (!parseAddress(command, pos, last)) {
+                last = current;
+            }
+            given = true;
+        }
+    }
+    
+    if (first > last) {
+        std::swap(first, last);
+    }
+    if (given && (first < 0 || last > lastLine)) {
+        editor_->setStatusMessage("Invalid range");
+        return false;
+    }
+    while (pos < command.size() && command[pos] == ' ') {
+        ++pos;
+    }
+    return true;
+}
+
+bool CommandProcessor::parseAddress(const std::string& command, size_t& pos, int& line) {
+    if (pos >= command.size()) return false;
+    
+    char c = command[pos];
+    if (std::isdigit(static_cast<unsigned char>(c))) {
+        int number = 0;
+        while (pos < command.size() && std::isdigit(static_cast<unsigned char>(command[pos]))) {
+            number = std::min(number * 10 + (command[pos++] - '0'), 1 << 30);
+        }
+        // Line 0 means the first line, as for :0
+        line = std::max(number, 1) - 1;
+    } else if (c == '.') {
+        line = editor_->getCursor().getRow();
+        ++pos;
+    } else if (c == '$') {
+        line = static_cast<int>(editor_->getCurrentBuffer()->getLines().size()) - 1;
+        ++pos;
+    } else if (c == '+' || c == '-') {
+        line = editor_->getCursor().getRow();
+    } else {
+        return false;
+    }
+    
+    // Offsets: "+3", "-", "$-1"
+    while (pos < command.size() && (command[pos] == '+' || command[pos] == '-')) {
+        int sign = command[pos++] == '+' ? 1 : -1;
+        int offset = 0;
+        bool digits = false;
+        while (pos < command.size() && std::isdigit(static_cast<unsigned char>(command[pos]))) {
+            offset = std::min(offset * 10 + (command[pos++] - '0'), 1 << 30);
+            digits = true;
+        }
+        line += sign * (digits ? offset : 1);
+    }
+    return true;
+}
+
+const std::regex* CommandProcessor::compilePattern(const std::string& source, bool ignoreCase) {
+    if (regexSource_ != source || regexIgnoreCase_ != ignoreCase || !regexValid_) {
+        regexSource_ = source;
+        regexIgnoreCase_ = ignoreCase;
+        try {
+            std::regex::flag_type flags = std::regex::ECMAScript;
+            if (ignoreCase) flags |= std::regex::icase;
+            regex_.assign(source, flags);
+            regexValid_ = true;
+        } catch (const std::regex_error&) {
+            regexValid_ = false;
+        }
+    }
+    return regexValid_ ? &regex_ : nullptr;
+}
+
+bool CommandProcessor::cmdSubstitute(int first, int last, const std::string& args) {
+    auto buffer = editor_->getCurrentBuffer();
+    if (args.empty() || !isPatternDelimiter(args[0])) {
+        editor_->setStatusMessage("Usage: :s/pattern/replacement/[flags]");
+        return false;
+    }
+    
+    size_t pos = 1;
+    std::string source = readDelimited(args, pos, args[0]);
+    Replacement replacement = translateReplacement(readDelimited(args, pos, args[0]));
+    
+    bool global = false;
+    bool ignoreCase = false;
+    bool quiet = false;
+    for (; pos < args.size(); ++pos) {
+        char flag = args[pos];
+        if (flag == 'g') global = true;
+        else if (flag == 'i') ignoreCase = true;
+        else if (flag == 'I') ignoreCase = false;
+        else if (flag == 'e') quiet = true;
+        else if (flag != ' ') {
+            editor_->setStatusMessage("Trailing characters: " + args.substr(pos));
+            return false;
+        }
+    }
+    if (source.empty()) {
+        editor_->setStatusMessage("Empty pattern");
+        return false;
+    }
+    
+    Pattern pattern = translatePattern(source);
+    bool literal = pattern.isLiteral && replacement.isLiteral && !ignoreCase;
+    const std::regex* regex = literal ? nullptr : compilePattern(pattern.regex, ignoreCase);
+    if (!literal && !regex) {
+        editor_->setStatusMessage("Invalid pattern: " + source);
+        return false;
+    }
+    
+    // Collect the new text of the changed span and replace it in one edit
+    const std::vector<std::string>& lines = buffer->getLines();
+    std::vector<std::string> changed;
+    int firstChanged = -1;
+    int lastChanged = -1;
+    int substitutions = 0;
+    int changedLines = 0;
+    std::string result;
+    for (int row = first; row <= last; ++row) {
+        int count = literal
+            ? replaceLiteral(lines[row], pattern.literal, replacement.literal, global, result)
+            : replaceRegex(lines[row], *regex, replacement.format, global, result);
+        if (count == 0) continue;
+        
+        if (firstChanged < 0) {
+            firstChanged = row;
+        } else {
+            changed.insert(changed.end(), lines.begin() + lastChanged + 1, lines.begin() + row);
+        }
+        changed.push_back(result);
+        lastChanged = row;
+        substitutions += count;
+        ++changedLines;
+    }
+    
+    if (substitutions == 0) {
+        if (quiet || globalDepth_ > 0) return true;
+        editor_->setStatusMessage("Pattern not found: " + source);
+        return false;
+    }
+    
+    std::vector<std::string> newLines;
+    if (replacement.hasNewline) {
+        for (size_t i = 0; i < changed.size(); ++i) {
+            std::vector<std::string> pieces = BufferUtils::splitLines(changed[i]);
+            newLines.insert(newLines.end(), pieces.begin(), pieces.end());
+        }
+    } else {
+        newLines.swap(changed);
+    }
+    
+    int inserted = static_cast<int>(newLines.size());
+    BufferUtils::replaceLines(*buffer, firstChanged, lastChanged - firstChanged + 1, newLines);
+    
+    // Like vim, the cursor ends on the last line substituted
+    int row = firstChanged + inserted - 1;
+    editor_->getCursor().setPosition(row, Motions::firstNonBlank(*buffer, row));
+    if (globalDepth_ == 0) {
+        std::stringstream ss;
+        ss << substitutions << (substitutions == 1 ? " substitution" : " substitutions")
+           << " on " << changedLines << (changedLines == 1 ? " line" : " lines");
+        editor_->setStatusMessage(ss.str());
+    }
+    return true;
+}
+
+bool CommandProcessor::cmdGlobal(int first, int last, bool invert, const std::string& args) {
+    if (globalDepth_ > 0) {
+        editor_->setStatusMessage("Cannot do :global recursive");
+        return false;
+    }
+    if (args.empty() || !isPatternDelimiter(args[0])) {
+        editor_->setStatusMessage("Usage: :g/pattern/command");
+        return false;
+    }
+    
+    size_t pos = 1;
+    std::string source = readDelimited(args, pos, args[0]);
+    std::string command = trim(args.substr(pos));
+    if (source.empty() || command.empty()) {
+        editor_->setStatusMessage("Usage: :g/pattern/command");
+        return false;
+    }
+    
+    Pattern pattern = translatePattern(source);
+    const std::regex* regex = pattern.isLiteral ? nullptr : compilePattern(pattern.regex, false);
+    if (!pattern.isLiteral && !regex) {
+        editor_->setStatusMessage("Invalid pattern: " + source);
+        return false;
+    }
+    
+    // Mark the lines first, then run the command on each, as vim does
+    auto buffer = editor_->getCurrentBuffer();
+    const std::vector<std::string>& lines = buffer->getLines();
+    std::vector<int> matches;
+    for (int row = first; row <= last; ++row) {
+        bool found = pattern.isLiteral ? lines[row].find(pattern.literal) != std::string::npos
+                                       : std::regex_search(lines[row], *regex);
+        if (found != invert) {
+            matches.push_back(row);
+        }
+    }
+    if (matches.empty()) {
+        editor_->setStatusMessage("Pattern not found: " + source);
+        return false;
+    }
+    
+    // :g/pattern/d is the common case: filter the range in one edit
+    // instead of deleting line by line
+    if (command == "d" || command == "delete") {
+        std::vector<std::string> kept;
+        size_t next = 0;
+        for (int row = first; row <= last; ++row) {
+            if (next < matches.size() && matches[next] == row) {
+                ++next;
+            } else {
+                kept.push_back(lines[row]);
+            }
+        }
+        int inserted = static_cast<int>(kept.size());
+        BufferUtils::replaceLines(*buffer, first, last - first + 1, kept);
+        
+        int row = std::min(first + inserted, static_cast<int>(buffer->getLines().size()) - 1);
+        editor_->getCursor().setPosition(row, Motions::firstNonBlank(*buffer, row));
+        return true;
+    }
+    
+    // Lines added or removed by the command shift the marked lines after it
+    ++globalDepth_;
+    bool ok = true;
+    int offset = 0;
+    for (size_t i = 0; i < matches.size() && !editor_->shouldQuit(); ++i) {
+        int lineCount = static_cast<int>(editor_->getCurrentBuffer()->getLines().size());
+        int row = matches[i] + offset;
+        if (row < 0 || row >= lineCount) break;
+        
+        editor_->getCursor().setPosition(row, 0);
+        if (!executeCommand(command)) {
+            ok = false;
+            break;
+        }
+        offset += static_cast<int>(editor_->getCurrentBuffer()->getLines().size()) - lineCount;
+    }
+    --globalDepth_;
+    return ok;
+}
+
+bool CommandProcessor::cmdDelete(int first, int last) {
+    // Through the operator, so the lines land in the register as with dd
+    Range range;
+    range.start.row = first;
+    range.start.col = 0;
+    range.end.row = last;
+    range.end.col = 0;
+    editor_->applyOperator('d', range, true);
+    return true;
+}
+
+bool CommandProcessor::cmdGoto(int line) {
+    auto buffer = editor_->getCurrentBuffer();
+    editor_->getCursor().setPosition(line, Motions::firstNonBlank(*buffer, line));
+    return true;
+}
+
 std::vector<std::string> CommandProcessor::parseCommand(const std::string& command) {
     std::vector<std::string> args;
     std::string current;
@@ -102,27 +697,39 @@ std::vector<std::string> CommandProcessor::parseCommand(const std::string& comma
     return args;
 }
 
-bool CommandProcessor::cmdQuit(const std::vector<std::string>& args) {
+bool CommandProcessor::cmdQuit(const std::vector<std::string>&) {
     if (!editor_) return false;
-    // Implementation will depend on the Editor class
-    // This is a placeholder
+    // Quitting drops the buffers, and a clean exit leaves no swap behind
+    if (editor_->hasUnsavedChanges()) {
+        editor_->setStatusMessage("No write since last change (add ! to override)");
+        return false;
+    }
+    editor_->requestQuit();
+    return true;
+}
+
+bool CommandProcessor::cmdQuitForce(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    editor_->requestQuit();
     return true;
 }
 
 bool CommandProcessor::cmdWrite(const std::vector<std::string>& args) {
     if (!editor_) return false;
     
+    // Write from a snapshot on the saver thread; editing continues meanwhile
     if (args.empty()) {
-        return editor_->saveFile();
+        return editor_->saveFileInBackground();
     } else {
-        return editor_->saveFileAs(args[0]);
+        return editor_->saveFileInBackground(args[0]);
     }
 }
 
 bool CommandProcessor::cmdWriteQuit(const std::vector<std::string>& args) {
     if (!editor_) return false;
     
-    bool result = cmdWrite(args);
+    // We are about to exit, so write synchronously
+    bool result = args.empty() ? editor_->saveFile() : editor_->saveFileAs(args[0]);
     if (result) {
         return cmdQuit(std::vector<std::string>());
     }
@@ -135,13 +742,15 @@ bool CommandProcessor::cmdEdit(const std::vector<std::string>& args) {
     return editor_->openFile(args[0]);
 }
 
-bool CommandProcessor::cmdNext(const std::vector<std::string>& args) {
-    // Implementation will depend on the Editor class
+bool CommandProcessor::cmdNext(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    editor_->nextBuffer();
     return true;
 }
 
-bool CommandProcessor::cmdPrev(const std::vector<std::string>& args) {
-    // Implementation will depend on the Editor class
+bool CommandProcessor::cmdPrev(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    editor_->prevBuffer();
     return true;
 }
 
@@ -151,12 +760,99 @@ bool CommandProcessor::cmdNumber(const std::vector<std::string>& args) {
 }
 
 bool CommandProcessor::cmdSet(const std::vector<std::string>& args) {
-    // Implementation will depend on the Editor class
+    if (!editor_) return false;
+    Settings* settings = editor_->getSettings();
+    if (!settings) return false;
+    
+    // Without arguments, list every option
+    if (args.empty()) {
+        std::string all;
+        for (int i = 0; i < SETTING_COUNT; ++i) {
+            SettingId id = static_cast<SettingId>(i);
+            if (i > 0) all += " ";
+            all += std::string(Settings::getName(id)) + "=" + settings->toString(id);
+        }
+        editor_->setStatusMessage(all);
+        return true;
+    }
+    
+    // Stop at the first bad argument, like vim
+    std::string message;
+    for (size_t i = 0; i < args.size(); ++i) {
+        std::string result;
+        if (!settings->apply(args[i], result)) {
+            editor_->setStatusMessage(result);
+            return false;
+        }
+        if (!result.empty()) {
+            message += (message.empty() ? "" : " ") + result;
+        }
+    }
+    if (!message.empty()) {
+        editor_->setStatusMessage(message);
+    }
     return true;
 }
 
 bool CommandProcessor::cmdHelp(const std::vector<std::string>& args) {
-    // Implementation will depend on the Editor class
+    if (!editor_) return false;
+    editor_->showHelp();
+    return true;
+}
+
+bool CommandProcessor::cmdBuffers(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    editor_->setStatusMessage(editor_->listBuffers());
+    return true;
+}
+
+bool CommandProcessor::cmdJobs(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    editor_->setStatusMessage(editor_->listJobs());
+    return true;
+}
+
+bool CommandProcessor::cmdRecover(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    return editor_->recoverSwap();
+}
+
+bool CommandProcessor::cmdDropSwap(const std::vector<std::string>&) {
+    if (!editor_) return false;
+    return editor_->discardSwap();
+}
+
+// :profile start|stop|dump FILE
+bool CommandProcessor::cmdProfile(const std::vector<std::string>& args) {
+    if (!editor_) return false;
+
+    std::ostringstream ss;
+    if (args.empty()) {
+        ss << "Profiling " << (Profiler::isEnabled() ? "on" : "off") << ", "
+           << Profiler::getEventCount() << " events";
+    } else if (args[0] == "start") {
+#ifdef CVIM_NO_PROFILE
+        editor_->setStatusMessage("Profiling was not compiled in");
+        return false;
+#else
+        Profiler::start();
+        ss << "Profiling started";
+#endif
+    } else if (args[0] == "stop") {
+        Profiler::stop();
+        ss << "Profiling stopped, " << Profiler::getEventCount() << " events";
+    } else if (args[0] == "dump" && args.size() == 2) {
+        std::string error;
+        if (!Profiler::dump(args[1], error)) {
+            editor_->setStatusMessage(error);
+            return false;
+        }
+        ss << "Wrote " << Profiler::getEventCount() << " events to " << args[1];
+    } else {
+        editor_->setStatusMessage("Usage: :profile start|stop|dump file.json");
+        return false;
+    }
+    editor_->setStatusMessage(ss.str());
     return true;
 }
 
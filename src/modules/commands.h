@@ -5,6 +5,7 @@
 #include <map>
 #include <functional>
 #include <vector>
+#include <regex>
 
 namespace cvim {
 
@@ -18,15 +19,35 @@ public:
     
     void setEditor(Editor* editor);
     
+    // Run one ex command line, optionally preceded by a line range
+    // ("%", "5", "1,$", ".,+3"). Errors are left in the status message.
     bool executeCommand(const std::string& command);
     std::vector<std::string> getCompletions(const std::string& partial);
     
 private:
+    // Ranges are 0-based and inclusive; they default to the cursor line
+    bool parseRange(const std::string& command, size_t& pos, int& first, int& last, bool& given);
+    // One address ("5", ".", "$", "+2", "$-1"); false if there is none
+    bool parseAddress(const std::string& command, size_t& pos, int& line);
+    
+    // Commands that take a range or a pattern, so cannot be split into words
+    bool cmdSubstitute(int first, int last, const std::string& args);
+    bool cmdGlobal(int first, int last, bool invert, const std::string& args);
+    bool cmdDelete(int first, int last);
+    bool cmdGoto(int line);
+    
+    // Compile a vim pattern, reusing the last one: batch runs apply the
+    // same :s to every file. Null if the pattern is invalid.
+    const std::regex* compilePattern(const std::string& source, bool ignoreCase);
+    
+
     // Register built-in commands
     void registerBuiltInCommands();
     
     // Command handlers
+    // :q refuses while a buffer has unsaved changes; :q! does not
     bool cmdQuit(const std::vector<std::string>& args);
+    bool cmdQuitForce(const std::vector<std::string>& args);
     bool cmdWrite(const std::vector<std::string>& args);
     bool cmdWriteQuit(const std::vector<std::string>& args);
     bool cmdEdit(const std::vector<std::string>& args);
@@ -35,6 +56,11 @@ private:
     bool cmdNumber(const std::vector<std::string>& args);
     bool cmdSet(const std::vector<std::string>& args);
     bool cmdHelp(const std::vector<std::string>& args);
+    bool cmdBuffers(const std::vector<std::string>& args);
+    bool cmdJobs(const std::vector<std::string>& args);
+    bool cmdRecover(const std::vector<std::string>& args);
+    bool cmdDropSwap(const std::vector<std::string>& args);
+    bool cmdProfile(const std::vector<std::string>& args);
     
     // Command parsing
     std::vector<std::string> parseCommand(const std::string& command);
@@ -44,6 +70,12 @@ private:
     
     // Map of command names to handler functions
     std::map<std::string, std::function<bool(const std::vector<std::string>&)> > commands_;
+    
+    std::string regexSource_;
+    bool regexIgnoreCase_;
+    bool regexValid_;
+    std::regex regex_;
+    int globalDepth_;  // inside :g, where "pattern not found" is no error
 };
 
 } // namespace cvim
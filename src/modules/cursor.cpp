@@ -1,5 +1,6 @@
 #include "cursor.h"
 #include "editor.h"
+#include "../utils/unicode.h"
 #include <climits>
 #include <algorithm>
 
@@ -118,8 +119,11 @@ void Cursor::limitToValidPosition(const std::shared_ptr<Buffer>& buffer) {
     
     // Limit column
     if (position_.row <= maxRow) {
-        int maxCol = buffer->getLines()[position_.row].length();
+        const std::string& line = buffer->getLines()[position_.row];
+        int maxCol = line.length();
         position_.col = std::max(0, std::min(position_.col, maxCol));
+        // Never inside a multibyte or combined character
+        position_.col = static_cast<int>(charStart(line, position_.col));
     } else {
         position_.col = 0;
     }
@@ -4,25 +4,49 @@
 #include "commands.h" // commands.h includes <functional>
 #include "filetree.h"
 #include "hotkeys.h"  // hotkeys.h includes <functional>
+#include "saver.h"
+#include "journal.h"
+#include "buffer_registry.h"
+#include "motions.h"
+#include "filewatch.h"
+#include "threadpool.h"
 #include "../config/config.h"
 #include "../utils/utils.h"
+#include "../utils/fileio.h"
+#include "../utils/startuptime.h"
+#include "../utils/profiler.h"
+#include "../utils/unicode.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cctype>
 #include <functional> // Added as safeguard
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
 
 namespace cvim {
 
 // Buffer implementation
-Buffer::Buffer(const std::string& filePath) : filePath_(filePath), modified_(false) {
-    lines_.push_back("");
+Buffer::Buffer(const std::string& filePath)
+    : filePath_(filePath), lines_(std::make_shared<std::vector<std::string> >()),
+      modified_(false), changeTick_(0), resident_(true), diskMtime_(0),
+      residentBytes_(0), residentBytesTick_(static_cast<unsigned long>(-1)),
+      columnIndexTick_(0), columnIndexTabSize_(0) {
+    lines_->push_back("");
     if (!filePath.empty()) {
         load();
     }
 }
 
-Buffer::~Buffer() {}
+Buffer::~Buffer() {
+    // Edits not on disk yet stay recoverable from the swap file
+    if (journal_ && !modified_) {
+        journal_->discard();
+    }
+}
 
 bool Buffer::load() {
     if (filePath_.empty()) return false;
@@ -30,117 +54,459 @@ bool Buffer::load() {
     std::ifstream file(filePath_);
     if (!file.is_open()) return false;
     
-    lines_.clear();
+    // Read into fresh storage so an outstanding snapshot stays intact
+    std::shared_ptr<std::vector<std::string> > lines = std::make_shared<std::vector<std::string> >();
     std::string line;
     while (std::getline(file, line)) {
         // Handle line endings
         if (!line.empty() && line.back() == '\r') {
             line.pop_back();
         }
-        lines_.push_back(line);
+        lines->push_back(line);
     }
     
-    if (lines_.empty()) {
-        lines_.push_back("");
+    if (lines->empty()) {
+        lines->push_back("");
     }
     
+    lines_ = lines;
+    ++changeTick_;
     modified_ = false;
+    resident_ = true;
+    refreshDiskMtime();
+    if (journal_) {
+        journal_->rebase(journal_->mark());
+    }
     return true;
 }
 
 bool Buffer::save() {
-    if (filePath_.empty()) return false;
+    // An evicted buffer holds only a placeholder
+    if (filePath_.empty() || !resident_) return false;
     
-    std::ofstream file(filePath_);
-    if (!file.is_open()) return false;
-    
-    for (const std::string& line : lines_) {
-        file << line << "\n";
-    }
+    // Write to a temp file and rename it over the original so a crash
+    // mid-save never destroys the file on disk
+    Result result = writeLinesAtomic(filePath_, *lines_);
+    if (result.isError()) return false;
     
     modified_ = false;
+    refreshDiskMtime();
+    if (journal_) {
+        // Everything journaled so far is now on disk
+        journal_->rebase(journal_->mark());
+    }
     return true;
 }
 
 bool Buffer::saveAs(const std::string& filePath) {
-    filePath_ = filePath;
+    setFilePath(filePath);
     return save();
 }
 
 void Buffer::insertChar(char c) {
-    if (lines_.empty()) {
-        lines_.push_back("");
+    std::vector<std::string>& lines = getMutableLines();
+    if (lines.empty()) {
+        lines.push_back("");
     }
     
     // Implementation would depend on cursor position being passed
     // This is simplified here
-    lines_[0] += c;
-    modified_ = true;
+    lines[0] += c;
+    setModified(true);
+    noteEdit(EDIT_INSERT_CHAR, 0, static_cast<int>(lines[0].size()) - 1, std::string(1, c));
 }
 
 void Buffer::insertLine(const std::string& line) {
-    lines_.push_back(line);
-    modified_ = true;
+    getMutableLines().push_back(line);
+    setModified(true);
+    noteEdit(EDIT_INSERT_LINE, static_cast<int>(lines_->size()) - 1, 0, line);
 }
 
 void Buffer::deleteLine(int line) {
-    if (line >= 0 && line < static_cast<int>(lines_.size())) {
-        lines_.erase(lines_.begin() + line);
-        modified_ = true;
+    if (line >= 0 && line < static_cast<int>(lines_->size())) {
+        std::vector<std::string>& lines = getMutableLines();
+        lines.erase(lines.begin() + line);
+        setModified(true);
+        noteEdit(EDIT_DELETE_LINE, line, 0);
         
-        if (lines_.empty()) {
-            lines_.push_back("");
+        if (lines.empty()) {
+            lines.push_back("");
         }
     }
 }
 
 void Buffer::deleteChar(int pos, int line) {
-    if (line >= 0 && line < static_cast<int>(lines_.size())) {
-        std::string& currentLine = lines_[line];
+    if (line >= 0 && line < static_cast<int>(lines_->size())) {
+        std::string& currentLine = getMutableLines()[line];
         if (pos >= 0 && pos < static_cast<int>(currentLine.size())) {
             currentLine.erase(pos, 1);
-            modified_ = true;
+            setModified(true);
+            noteEdit(EDIT_DELETE_CHAR, line, pos);
         }
     }
 }
 
 const std::vector<std::string>& Buffer::getLines() const {
-    return lines_;
+    return *lines_;
+}
+
+std::vector<std::string>& Buffer::getMutableLines() {
+    // Copy-on-write: a background save may still be reading the old lines
+    if (lines_.use_count() > 1) {
+        lines_ = std::make_shared<std::vector<std::string> >(*lines_);
+    }
+    return *lines_;
 }
 
 const std::string& Buffer::getFilePath() const {
     return filePath_;
 }
 
+void Buffer::setFilePath(const std::string& filePath) {
+    if (filePath != filePath_) {
+        // The journal describes the old file; the editor attaches a new one
+        journal_.reset();
+    }
+    filePath_ = filePath;
+}
+
 bool Buffer::isModified() const {
     return modified_;
 }
 
 void Buffer::setModified(bool modified) {
     modified_ = modified;
+    if (modified) {
+        ++changeTick_;
+    }
+}
+
+std::shared_ptr<const std::vector<std::string> > Buffer::snapshot() const {
+    return lines_;
+}
+
+void Buffer::adoptCopy(const std::shared_ptr<const std::vector<std::string> >& source,
+                       const std::shared_ptr<std::vector<std::string> >& copy) {
+    // Same contents, so nothing cached about the lines goes stale
+    if (copy && lines_ == source) {
+        lines_ = copy;
+    }
+}
+
+// Seconds are too coarse: a save right after ours would look unchanged
+static long long fileMtime(const std::string& filePath) {
+    struct stat st;
+    if (stat(filePath.c_str(), &st) != 0) return 0;
+    return static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+void Buffer::refreshDiskMtime() {
+    diskMtime_ = fileMtime(filePath_);
+}
+
+bool Buffer::changedOnDisk() {
+    long long mtime = fileMtime(filePath_);
+    if (mtime == 0 || mtime == diskMtime_) return false;
+    diskMtime_ = mtime;
+    return true;
+}
+
+bool Buffer::canEvict() const {
+    return resident_ && !modified_ && !filePath_.empty();
+}
+
+void Buffer::evict() {
+    if (!canEvict()) return;
+    
+    // Keep a one-line placeholder so readers never see an empty buffer
+    lines_ = std::make_shared<std::vector<std::string> >(1, std::string());
+    ++changeTick_;
+    resident_ = false;
+}
+
+bool Buffer::isResident() const {
+    return resident_;
+}
+
+bool Buffer::ensureLoaded() {
+    if (resident_) return true;
+    
+    // Only unmodified buffers are evicted, so whatever is on disk now,
+    // even if it changed meanwhile, is what the buffer should show
+    return load();
+}
+
+size_t Buffer::getResidentBytes() const {
+    if (residentBytesTick_ != changeTick_) {
+        size_t bytes = sizeof(Buffer) + lines_->capacity() * sizeof(std::string);
+        for (size_t i = 0; i < lines_->size(); ++i) {
+            // Short strings live inside the std::string object itself
+            if ((*lines_)[i].capacity() > 15) {
+                bytes += (*lines_)[i].capacity() + 1;
+            }
+        }
+        residentBytes_ = bytes;
+        residentBytesTick_ = changeTick_;
+    }
+    return residentBytes_;
+}
+
+int Buffer::getDisplayColumn(int row, int col, int tabSize) const {
+    if (row < 0 || row >= static_cast<int>(lines_->size()) || col <= 0) return 0;
+    const std::string& line = (*lines_)[row];
+    const ColumnIndex* index = getColumnIndex(row, tabSize, ColumnIndex::STEP);
+    if (index) {
+        return index->getColumn(line, static_cast<size_t>(col));
+    }
+    return displayColumn(line, static_cast<size_t>(col), tabSize);
+}
+
+int Buffer::getByteColumn(int row, int displayCol, int tabSize) const {
+    return static_cast<int>(getColumnMark(row, displayCol, tabSize).byte);
+}
+
+ColumnMark Buffer::getColumnMark(int row, int displayCol, int tabSize) const {
+    ColumnMark mark = { 0, 0 };
+    if (row < 0 || row >= static_cast<int>(lines_->size()) || displayCol <= 0) return mark;
+    const std::string& line = (*lines_)[row];
+    const ColumnIndex* index = getColumnIndex(row, tabSize, ColumnIndex::STEP);
+    if (index) {
+        return index->getMark(line, displayCol);
+    }
+    return markAtColumn(line, displayCol, tabSize);
+}
+
+int Buffer::getDisplayWidth(int row, int tabSize) const {
+    if (row < 0 || row >= static_cast<int>(lines_->size())) return 0;
+    const std::string& line = (*lines_)[row];
+    const ColumnIndex* index = getColumnIndex(row, tabSize, ColumnIndex::STEP);
+    if (index) {
+        return index->getWidth(line);
+    }
+    return displayColumn(line, line.size(), tabSize);
+}
+
+int Buffer::getWrapRowCount(int row, int width, int tabSize) const {
+    const std::vector<ColumnMark>* rows = getWrapRows(row, width, tabSize, std::string::npos, std::string::npos);
+    return rows ? static_cast<int>(rows->size()) : 1;
+}
+
+bool Buffer::hasWrapRow(int row, int wrapRow, int width, int tabSize) const {
+    if (row < 0 || row >= static_cast<int>(lines_->size()) || wrapRow < 0) return false;
+    if (wrapRow == 0) return true;
+    const std::vector<ColumnMark>* rows = getWrapRows(row, width, tabSize, wrapRow + 1, 0);
+    return rows && static_cast<size_t>(wrapRow) < rows->size();
+}
+
+ColumnMark Buffer::getWrapRowStart(int row, int wrapRow, int width, int tabSize) const {
+    if (wrapRow > 0) {
+        const std::vector<ColumnMark>* rows = getWrapRows(row, width, tabSize, wrapRow + 1, 0);
+        if (rows) return (*rows)[std::min(static_cast<size_t>(wrapRow), rows->size() - 1)];
+    }
+    ColumnMark start = { 0, 0 };
+    return start;
+}
+
+int Buffer::getWrapRow(int row, int col, int width, int tabSize) const {
+    // Laid out until a row starts past col
+    const std::vector<ColumnMark>* rows = getWrapRows(row, width, tabSize, 0, std::max(0, col) + 1);
+    if (!rows) return 0;
+    // Last row starting at or before col
+    size_t low = 0;
+    size_t high = rows->size();
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (static_cast<int>((*rows)[middle].byte) <= col) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return static_cast<int>(low);
+}
+
+const std::vector<ColumnMark>* Buffer::getWrapRows(int row, int width, int tabSize,
+                                                   size_t minRows, size_t minByte) const {
+    if (row < 0 || row >= static_cast<int>(lines_->size()) || width <= 0) return nullptr;
+    const std::string& line = (*lines_)[row];
+    // No character takes more cells than bytes, except a tab
+    if (line.size() <= static_cast<size_t>(width) && line.find('\t') == std::string::npos) return nullptr;
+    // A second row, if there is one, tells whether the line wraps at all
+    const std::vector<ColumnMark>& rows =
+        getColumnIndex(row, tabSize, 0)->getRows(line, width, std::max<size_t>(minRows, 2), minByte);
+    return rows.size() > 1 ? &rows : nullptr;
+}
+
+const ColumnIndex* Buffer::getColumnIndex(int row, int tabSize, size_t minLength) const {
+    const std::string& line = (*lines_)[row];
+    // Scanning a short line costs less than keeping an index for it
+    if (line.size() <= minLength) return nullptr;
+    
+    // Anything not reported through noteEdit (loads, journal replay) throws
+    // the whole cache away
+    if (columnIndexTick_ != changeTick_ || columnIndexTabSize_ != tabSize ||
+        columnIndex_.size() != lines_->size()) {
+        columnIndex_.assign(lines_->size(), std::shared_ptr<ColumnIndex>());
+        columnIndexTick_ = changeTick_;
+        columnIndexTabSize_ = tabSize;
+    }
+    if (!columnIndex_[row]) {
+        columnIndex_[row] = std::make_shared<ColumnIndex>(tabSize);
+    }
+    return columnIndex_[row].get();
+}
+
+void Buffer::updateColumnIndex(EditOp op, int row, int col, const std::string& text) {
+    if (columnIndex_.empty()) return;
+    // Only the change this call reports may be missing from the cache
+    if (changeTick_ != columnIndexTick_ + 1 || row < 0 ||
+        row > static_cast<int>(columnIndex_.size())) {
+        columnIndex_.clear();
+        return;
+    }
+    
+    typedef std::vector<std::shared_ptr<ColumnIndex> >::iterator Iterator;
+    int lineCount = static_cast<int>(columnIndex_.size());
+    int newlines = static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+    Iterator at = columnIndex_.begin() + row;
+    switch (op) {
+        case EDIT_INSERT_CHAR:
+        case EDIT_DELETE_CHAR:
+            // Only what follows col on the line moves
+            if (row < lineCount && *at) {
+                (*at)->edit((*lines_)[row], col, op == EDIT_DELETE_CHAR ? 1 : 0, text.size());
+            }
+            break;
+        case EDIT_LINE_BREAK:
+        case EDIT_INSERT_TEXT:
+            if (op == EDIT_INSERT_TEXT && newlines == 0) {
+                if (row < lineCount && *at) (*at)->edit((*lines_)[row], col, 0, text.size());
+            } else if (row < lineCount) {
+                at->reset();
+                columnIndex_.insert(at + 1, op == EDIT_LINE_BREAK ? 1 : newlines,
+                                    std::shared_ptr<ColumnIndex>());
+            }
+            break;
+        case EDIT_JOIN_LINES:
+        case EDIT_DELETE_TEXT: {
+            int joined = op == EDIT_JOIN_LINES ? 1 : newlines;
+            if (joined == 0) {
+                if (row < lineCount && *at) (*at)->edit((*lines_)[row], col, text.size(), 0);
+            } else if (row < lineCount && row + joined < lineCount) {
+                at->reset();
+                columnIndex_.erase(at + 1, at + 1 + joined);
+            }
+            break;
+        }
+        case EDIT_INSERT_LINE:
+        case EDIT_INSERT_LINES:
+            columnIndex_.insert(at, op == EDIT_INSERT_LINE ? 1 : newlines + 1,
+                                std::shared_ptr<ColumnIndex>());
+            break;
+        case EDIT_DELETE_LINE:
+        case EDIT_DELETE_LINES: {
+            int count = op == EDIT_DELETE_LINE ? 1 : col;
+            if (row + count <= lineCount) {
+                columnIndex_.erase(at, at + count);
+            }
+            break;
+        }
+        case EDIT_REPLACE_LINES:
+            if (row + col <= lineCount) {
+                at = columnIndex_.erase(at, at + col);
+                columnIndex_.insert(at, newlines + 1, std::shared_ptr<ColumnIndex>());
+            }
+            break;
+    }
+    
+    if (columnIndex_.size() == lines_->size()) {
+        columnIndexTick_ = changeTick_;
+    } else {
+        columnIndex_.clear();
+    }
+}
+
+void Buffer::noteEdit(EditOp op, int row, int col, const std::string& text) {
+    updateColumnIndex(op, row, col, text);
+    if (journal_) {
+        journal_->append(op, row, col, text);
+    }
+}
+
+void Buffer::setJournal(const std::shared_ptr<Journal>& journal) {
+    journal_ = journal;
+}
+
+std::shared_ptr<Journal> Buffer::getJournal() const {
+    return journal_;
+}
+
+unsigned long Buffer::getChangeTick() const {
+    return changeTick_;
+}
+
+void Buffer::markSaved(unsigned long changeTick) {
+    if (changeTick == changeTick_) {
+        modified_ = false;
+    }
 }
 
 // Editor implementation
 Editor::Editor() : terminal_(nullptr), config_(nullptr), tabManager_(nullptr), 
                    commandProcessor_(nullptr), fileTree_(nullptr), state_(), 
-                   hotkeyManager_(nullptr) {}
+                   hotkeyManager_(nullptr), asyncSaver_(nullptr),
+                   journalWriter_(nullptr), bufferRegistry_(nullptr), fileWatcher_(nullptr),
+                   threadPool_(nullptr), settingsListener_(-1),
+                   configGeneration_(0),
+                   registerLinewise_(false), recordingRegister_(0), lastMacro_(0),
+                   replayDepth_(0) {}
 
 Editor::~Editor() {
+    // Finish any in-flight write before the buffers go away
+    delete asyncSaver_;
     delete tabManager_;
     delete commandProcessor_;
     delete fileTree_;
     delete hotkeyManager_;
+    delete journalWriter_;
+    delete bufferRegistry_;
+    delete fileWatcher_;
+    // Last: the components above may still have jobs queued on it
+    delete threadPool_;
 }
 
 void Editor::initialize(Terminal* terminal, Config* config) {
     terminal_ = terminal;
     config_ = config;
     
-    // Initialize components
+    // Only what the first frame needs; the rest waits for finishStartup()
     tabManager_ = new TabManager();
     commandProcessor_ = new CommandProcessor(this);
-    fileTree_ = new FileTree();
     hotkeyManager_ = new HotkeyManager(this);
+    bufferRegistry_ = new BufferRegistry();
+    // Headless (no terminal, cvim -es): no swap files and nothing to watch
+    if (terminal_) {
+        journalWriter_ = new JournalWriter();
+        fileWatcher_ = new FileWatcher();
+    }
+    StartupTrace::mark("editor components");
+    
+    // Inactive, unmodified buffers beyond the budget are dropped from memory
+    if (config_) {
+        Settings& settings = config_->getSettings();
+        tabManager_->setMemoryBudget(static_cast<size_t>(settings.getInteger(SETTING_MEMORY_BUDGET)) << 20);
+        hotkeyManager_->setTimeout(settings.getInteger(SETTING_TIMEOUT_LEN));
+        
+        // Options copied into components follow :set and config loads
+        settingsListener_ = settings.addListener([this](SettingId id) {
+            Settings& current = config_->getSettings();
+            if (id == SETTING_MEMORY_BUDGET) {
+                tabManager_->setMemoryBudget(static_cast<size_t>(current.getInteger(id)) << 20);
+            } else if (id == SETTING_TIMEOUT_LEN) {
+                hotkeyManager_->setTimeout(current.getInteger(id));
+            }
+        });
+    }
     
     // Create empty buffer if none exists
     if (tabManager_->isEmpty()) {
@@ -148,41 +514,125 @@ void Editor::initialize(Terminal* terminal, Config* config) {
     }
 }
 
+void Editor::finishStartup() {
+    if (threadPool_) return;
+    
+    // The config file is parsed here rather than before the first frame;
+    // settings reach the components through their listeners
+    if (config_) {
+        if (!config_->load() && !config_->getError().empty()) {
+            state_.statusMessage = config_->getError();
+        }
+        StartupTrace::mark("config file");
+    }
+    
+    // Sized by the config, so it cannot start any earlier
+    threadPool_ = new ThreadPool(config_ ? config_->getSettings().getInteger(SETTING_THREADS) : 0);
+    if (wakeup_) {
+        threadPool_->setNotifier(wakeup_);
+    }
+    asyncSaver_ = new AsyncSaver(threadPool_);
+    StartupTrace::mark("thread pool");
+    
+    watchConfig();
+    StartupTrace::mark("key bindings");
+}
+
+FileTree* Editor::getFileTree() {
+    // Nothing needs it at startup
+    if (!fileTree_) {
+        fileTree_ = new FileTree();
+    }
+    return fileTree_;
+}
+
 void Editor::handleInput(const KeyInput& input) {
-    // First try the hotkey manager
-    if (hotkeyManager_->handleKey(state_.mode, input)) {
-        // The input was handled by hotkeys
-        updateStatusLine();
+    PROFILE_SCOPE("Editor::handleInput");
+
+    // Keys typed while recording; replayed keys belong to the macro that
+    // replays them, and idle reads carry no key at all
+    bool record = recordingRegister_ != 0 && replayDepth_ == 0 && input.key != Key::UNKNOWN;
+    if (record && state_.mode == Mode::NORMAL && input.key == Key::NORMAL &&
+        input.character == 'q' && !hotkeyManager_->isPending()) {
+        stopRecording();
         return;
     }
     
-    // Otherwise use the mode-specific handlers
-    switch (state_.mode) { // Now uses plain enum Mode
-        case NORMAL:
-            handleNormalMode(input);
-            break;
-        case INSERT:
-            handleInsertMode(input);
-            break;
-        case VISUAL:
-        case VISUAL_LINE:
-            handleVisualMode(input);
-            break;
-        case COMMAND:
-            handleCommandMode(input);
-            break;
+    // Track what insert mode types, so "." can put the same text back
+    if (state_.mode == Mode::INSERT) {
+        if (input.key == Key::NORMAL) {
+            insertedText_ += input.character;
+        } else if (input.key == Key::ENTER) {
+            insertedText_ += '\n';
+        } else if (input.key == Key::BACKSPACE && !insertedText_.empty()) {
+            insertedText_.erase(insertedText_.size() - 1);
+        }
     }
     
-    updateStatusLine();
+    // First try the hotkey manager, otherwise use the mode-specific handlers
+    if (!hotkeyManager_->handleKey(state_.mode, input)) {
+        switch (state_.mode) { // Now uses plain enum Mode
+            case NORMAL:
+                handleNormalMode(input);
+                break;
+            case INSERT:
+                handleInsertMode(input);
+                break;
+            case VISUAL:
+            case VISUAL_LINE:
+                handleVisualMode(input);
+                break;
+            case COMMAND:
+                handleCommandMode(input);
+                break;
+        }
+    }
+    
+    if (record && recordingRegister_ != 0) {
+        macros_[recordingRegister_].push_back(input);
+    }
 }
 
 bool Editor::openFile(const std::string& filePath) {
-    auto buffer = std::make_shared<Buffer>(filePath);
-    if (buffer->load()) {
-        tabManager_->addTab(buffer);
-        return true;
+    // The registry hands back the live buffer if this file is already open
+    bool created = false;
+    auto buffer = bufferRegistry_->open(filePath, created);
+    if (!buffer) {
+        return false;
     }
-    return false;
+    
+    int existing = tabManager_->findTab(buffer);
+    if (existing >= 0) {
+        if (!tabManager_->switchTab(existing)) {
+            reportUnloaded(buffer);
+            return false;
+        }
+    } else {
+        // Reuse the tab of the untouched startup buffer
+        auto current = getCurrentBuffer();
+        if (current && current->getFilePath().empty() && !current->isModified() &&
+            current->getLines().size() == 1 && current->getLines()[0].empty()) {
+            tabManager_->replaceTab(tabManager_->getCurrentIndex(), buffer);
+        } else {
+            tabManager_->addTab(buffer);
+            tabManager_->switchTab(tabManager_->getTabCount() - 1);
+        }
+    }
+    cursor_.setPosition(0, 0);
+    viewport_.reset();
+    
+    if (created && fileWatcher_) {
+        fileWatcher_->watch(filePath);
+        
+        // Never clobber a leftover swap file: let the user decide first
+        if (Journal::hasLeftover(filePath)) {
+            state_.statusMessage = "Found swap file " + Journal::swapPathFor(filePath) +
+                                   ": :recover to replay it, :dropswap to delete it";
+        } else {
+            attachJournal(buffer, false);
+        }
+    }
+    return true;
 }
 
 bool Editor::saveFile() {
@@ -193,7 +643,16 @@ bool Editor::saveFile() {
             state_.statusMessage = "No filename. Use :w filename";
             return false;
         }
-        return buffer->save();
+        if (!checkResident(buffer)) return false;
+        // Don't race a background write to the same file
+        if (asyncSaver_) {
+            asyncSaver_->wait();
+            processBackgroundTasks();
+        }
+        if (!buffer->save()) return false;
+        // The rename gave the file a new inode
+        bufferRegistry_->track(buffer);
+        return true;
     }
     return false;
 }
@@ -201,27 +660,242 @@ bool Editor::saveFile() {
 bool Editor::saveFileAs(const std::string& filePath) {
     auto buffer = getCurrentBuffer();
     if (buffer) {
-        return buffer->saveAs(filePath);
+        if (!checkResident(buffer)) return false;
+        if (asyncSaver_) {
+            asyncSaver_->wait();
+            processBackgroundTasks();
+        }
+        bool renamed = filePath != buffer->getFilePath();
+        if (!buffer->saveAs(filePath)) return false;
+        if (renamed) {
+            attachJournal(buffer, false);
+            if (fileWatcher_) fileWatcher_->watch(filePath);
+        }
+        bufferRegistry_->track(buffer);
+        return true;
     }
     return false;
 }
 
-ViewData Editor::getViewData() const {
-    ViewData viewData;
+bool Editor::checkResident(const std::shared_ptr<Buffer>& buffer) {
+    if (buffer->isResident()) return true;
+    // Only the placeholder of an evicted buffer is in memory
+    state_.statusMessage = buffer->getFilePath() + " is not loaded; not writing it";
+    return false;
+}
+
+bool Editor::saveFileInBackground(const std::string& filePath) {
+    auto buffer = getCurrentBuffer();
+    if (!buffer) return false;
+    
+    // Before finishStartup(), and always when headless, there is no saver
+    if (!asyncSaver_) {
+        return filePath.empty() ? saveFile() : saveFileAs(filePath);
+    }
+    if (!checkResident(buffer)) return false;
+    
+    if (!filePath.empty() && filePath != buffer->getFilePath()) {
+        buffer->setFilePath(filePath);
+        attachJournal(buffer, false);
+        if (fileWatcher_) fileWatcher_->watch(filePath);
+    }
+    if (buffer->getFilePath().empty()) {
+        state_.statusMessage = "No filename. Use :w filename";
+        return false;
+    }
+    if (asyncSaver_->isBusy()) {
+        state_.statusMessage = "Save already in progress";
+        return false;
+    }
+    
+    return asyncSaver_->start(buffer, buffer->getFilePath());
+}
+
+bool Editor::processBackgroundTasks() {
+    bool changed = false;
+    
+    // Finished jobs hand their results over on this thread
+    if (threadPool_ && threadPool_->runCompletions() > 0) {
+        changed = true;
+    }
+    
+    // An ambiguous key prefix resolves once nothing follows it in time
+    if (hotkeyManager_ && hotkeyManager_->checkTimeout()) {
+        changed = true;
+    }
+    
+    std::string message;
+    if (asyncSaver_ && asyncSaver_->poll(message)) {
+        // Register the buffer under the file's new inode (or new name)
+        std::shared_ptr<Buffer> saved = asyncSaver_->getBuffer();
+        bufferRegistry_->track(saved);
+        if (saved && saved->getFilePath() == asyncSaver_->getPath()) {
+            saved->refreshDiskMtime();
+        }
+        state_.statusMessage = message;
+        changed = true;
+    }
+    
+    // The records stay queued and are retried, but the user should know
+    // the swap file is behind
+    auto buffer = tabManager_ ? tabManager_->getCurrentBuffer() : nullptr;
+    if (buffer && buffer->getJournal()) {
+        std::string error = buffer->getJournal()->takeError();
+        if (!error.empty()) {
+            state_.statusMessage = "Cannot write swap file " + buffer->getJournal()->getSwapPath() +
+                                   ": " + error + " (retrying)";
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool Editor::hasPendingWork() const {
+    return (asyncSaver_ && asyncSaver_->isBusy()) ||
+           (hotkeyManager_ && hotkeyManager_->isWaitingForTimeout());
+}
+
+void Editor::setWakeup(std::function<void()> wakeup) {
+    wakeup_ = wakeup;
+    if (threadPool_) {
+        threadPool_->setNotifier(wakeup);
+    }
+    if (journalWriter_) {
+        journalWriter_->setNotifier(wakeup);
+    }
+}
+
+int Editor::getWatchFd() const {
+    return fileWatcher_ ? fileWatcher_->getFd() : -1;
+}
+
+bool Editor::handleFileChanges() {
+    if (!fileWatcher_) return false;
+    
+    // Our own finished save shows up here too; account for it first
+    bool changed = processBackgroundTasks();
+    
+    std::string configPath = config_ ? normalizePath(config_->getConfigPath()) : "";
+    std::vector<std::string> paths = fileWatcher_->readChanges();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!configPath.empty() && normalizePath(paths[i]) == configPath) {
+            reloadConfig();
+            continue;
+        }
+        if (asyncSaver_ && asyncSaver_->isBusy() && asyncSaver_->getPath() == paths[i]) continue;
+        
+        std::shared_ptr<Buffer> buffer = bufferRegistry_->find(paths[i]);
+        if (!buffer || !buffer->changedOnDisk()) continue;
+        
+        state_.statusMessage = "\"" + buffer->getFilePath() + "\" changed on disk";
+        changed = true;
+    }
+    return changed;
+}
+
+void Editor::watchConfig() {
+    if (!config_) return;
+    
+    if (fileWatcher_) fileWatcher_->watch(config_->getConfigPath());
+    
+    std::string error;
+    if (!hotkeyManager_->applyKeyBindings(config_->getKeyBindings(), error)) {
+        state_.statusMessage = error;
+    }
+}
+
+void Editor::reloadConfig() {
+    if (!config_ || !threadPool_) return;
+    
+    // Parse into a fresh Config off the main thread; the completion swaps
+    // in whatever differs. A newer change supersedes a reload in flight.
+    unsigned generation = ++configGeneration_;
+    std::string path = config_->getConfigPath();
+    std::shared_ptr<Config> fresh = std::make_shared<Config>();
+    std::shared_ptr<bool> loaded = std::make_shared<bool>(false);
+    
+    threadPool_->submit(ThreadPool::PRIORITY_BACKGROUND,
+        [fresh, loaded, path](const CancelToken&) {
+            *loaded = fresh->load(path);
+        },
+        [this, fresh, loaded, generation](bool cancelled) {
+            if (cancelled || generation != configGeneration_) return;
+            if (!*loaded) {
+                // A half-written or broken file keeps the current config
+                if (!fresh->getError().empty()) {
+                    state_.statusMessage = fresh->getError();
+                }
+                return;
+            }
+            
+            // Settings notify their listeners themselves
+            int changes = config_->update(*fresh);
+            std::string message = "Config reloaded";
+            if (changes & CONFIG_KEYBINDINGS_CHANGED) {
+                std::string error;
+                if (!hotkeyManager_->applyKeyBindings(config_->getKeyBindings(), error)) {
+                    message += ": " + error;
+                }
+            }
+            if (changes) {
+                state_.statusMessage = message;
+            }
+        });
+}
+
+const ViewData& Editor::getViewData() const {
+    PROFILE_SCOPE("Editor::getViewData");
+    // Filled in place, so a steady frame reuses last frame's strings
+    ViewData& viewData = viewData_;
     viewData.mode = getModeString(state_.mode);
-    viewData.statusLine = state_.statusMessage;
+    updateStatusLine();
+    viewData.statusLine = statusLine_.getText();
     viewData.commandLine = state_.commandBuffer;
     viewData.cursorRow = cursor_.getRow();
     viewData.cursorCol = cursor_.getCol();
     
     auto buffer = tabManager_->getCurrentBuffer();
     if (buffer) {
-        viewData.lines = buffer->getLines();
+        // Only the rows on screen, in cells rather than bytes
+        Size size = { 24, 80 };
+        if (terminal_) {
+            size = terminal_->getSize();
+        }
+        viewport_.setSize(size.height - 2, size.width);
+        viewport_.setWrap(config_ && config_->getSettings().getBoolean(SETTING_WRAP_TEXT));
+        viewport_.setTabSize(getTabSize());
+        viewport_.setSideScroll(config_ ? config_->getSettings().getInteger(SETTING_SIDE_SCROLL) : 0);
+        viewport_.setGutter(config_ && config_->getSettings().getBoolean(SETTING_LINE_NUMBERS),
+                            config_ && config_->getSettings().getBoolean(SETTING_RELATIVE_LINE));
+        viewport_.layout(*buffer, cursor_.getPosition(), viewData.lines, viewData.cursorRow, viewData.cursorCol);
+    } else {
+        viewData.lines.clear();
     }
     
     return viewData;
 }
 
+void Editor::scrollColumns(int columns) {
+    auto buffer = getCurrentBuffer();
+    if (!buffer) return;
+    viewport_.scrollColumns(columns);
+    Position pos = viewport_.keepInView(*buffer, cursor_.getPosition());
+    cursor_.setPosition(pos.row, pos.col);
+}
+
+int Editor::getTabSize() const {
+    int tabSize = config_ ? config_->getSettings().getInteger(SETTING_TAB_SIZE) : 4;
+    return tabSize > 0 ? tabSize : 4;
+}
+
+bool Editor::isShowingPerf() const {
+    return config_ && config_->getSettings().getBoolean(SETTING_SHOW_PERF);
+}
+
+void Editor::recordFrame(long long inputLatencyNs, long long frameNs, long long frameBytes) {
+    perfStats_.recordFrame(inputLatencyNs, frameNs, frameBytes);
+}
+
 bool Editor::shouldQuit() const {
     return state_.quit;
 }
@@ -257,6 +931,17 @@ void Editor::handleInsertMode(const KeyInput& input) {
             BufferUtils::insertCharAtPosition(*buffer, cursor_.getRow(), cursor_.getCol(), input.character);
             cursor_.moveRight(1);
         }
+    } else if (input.key == Key::TAB) {
+        // Spaces up to the next tab stop with expandTab, else a real tab
+        std::string text = "\t";
+        if (config_ && config_->getSettings().getBoolean(SETTING_EXPAND_TAB)) {
+            int tabSize = getTabSize();
+            auto buffer = getCurrentBuffer();
+            int column = buffer ? buffer->getDisplayColumn(cursor_.getRow(), cursor_.getCol(), tabSize) : 0;
+            text.assign(tabSize - column % tabSize, ' ');
+        }
+        insertAtCursor(text);
+        insertedText_ += text;
     } else if (input.key == Key::ENTER) {
         auto buffer = getCurrentBuffer();
         if (buffer) {
@@ -270,8 +955,12 @@ void Editor::handleInsertMode(const KeyInput& input) {
         if (buffer) {
             // Handle backspace
             if (cursor_.getCol() > 0) {
-                BufferUtils::deleteCharAtPosition(*buffer, cursor_.getRow(), cursor_.getCol() - 1);
-                cursor_.moveLeft(1);
+                Range range;
+                range.end = cursor_.getPosition();
+                range.start = range.end;
+                range.start.col = BufferUtils::prevCharStart(*buffer, range.end.row, range.end.col);
+                BufferUtils::deleteText(*buffer, range);
+                cursor_.setCol(range.start.col);
             } else if (cursor_.getRow() > 0) {
                 // Join with previous line
                 int prevLineLength = BufferUtils::getLineLength(*buffer, cursor_.getRow() - 1);
@@ -351,6 +1040,176 @@ void Editor::clearCommandBuffer() {
     state_.commandBuffer.clear();
 }
 
+void Editor::setStatusMessage(const std::string& message) {
+    state_.statusMessage = message;
+}
+
+void Editor::requestQuit() {
+    state_.quit = true;
+}
+
+bool Editor::hasUnsavedChanges() const {
+    if (!tabManager_) return false;
+    for (int i = 0; i < tabManager_->getTabCount(); ++i) {
+        if (tabManager_->getBuffer(i)->isModified()) return true;
+    }
+    return false;
+}
+
+void Editor::cancelQuit() {
+    state_.quit = false;
+}
+
+const std::string& Editor::getStatusMessage() const {
+    return state_.statusMessage;
+}
+
+void Editor::closeBuffer() {
+    if (!tabManager_) return;
+    
+    // Keep one (empty) tab, as at startup
+    int index = tabManager_->getCurrentIndex();
+    if (tabManager_->getTabCount() <= 1) {
+        tabManager_->replaceTab(index, std::make_shared<Buffer>());
+    } else {
+        tabManager_->removeTab(index);
+        if (!tabManager_->switchTab(tabManager_->getCurrentIndex())) {
+            // Nowhere else to go; saving stays refused while it is unloaded
+            reportUnloaded(getCurrentBuffer());
+        }
+    }
+    cursor_.setPosition(0, 0);
+    cursor_.limitToValidPosition(getCurrentBuffer());
+    viewport_.reset();
+}
+
+void Editor::nextBuffer() {
+    if (!tabManager_->nextTab()) {
+        reportUnloaded(tabManager_->getBuffer((tabManager_->getCurrentIndex() + 1) % tabManager_->getTabCount()));
+    }
+    cursor_.limitToValidPosition(getCurrentBuffer());
+}
+
+void Editor::prevBuffer() {
+    int count = tabManager_->getTabCount();
+    if (!tabManager_->prevTab()) {
+        reportUnloaded(tabManager_->getBuffer((tabManager_->getCurrentIndex() + count - 1) % count));
+    }
+    cursor_.limitToValidPosition(getCurrentBuffer());
+}
+
+void Editor::reportUnloaded(const std::shared_ptr<Buffer>& buffer) {
+    if (!buffer) return;
+    state_.statusMessage = "Cannot read " + buffer->getFilePath() + " back in; it stays unloaded";
+}
+
+static std::string formatBytes(size_t bytes) {
+    std::stringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(1);
+    if (bytes >= (1 << 20)) {
+        ss << bytes / 1048576.0 << "M";
+    } else if (bytes >= 1024) {
+        ss << bytes / 1024.0 << "K";
+    } else {
+        ss << bytes << "B";
+    }
+    return ss.str();
+}
+
+std::string Editor::listBuffers() const {
+    std::stringstream ss;
+    for (int i = 0; i < tabManager_->getTabCount(); ++i) {
+        auto buffer = tabManager_->getBuffer(i);
+        if (i > 0) ss << " | ";
+        ss << (i + 1) << (i == tabManager_->getCurrentIndex() ? "%" : " ")
+           << (buffer->isModified() ? "+" : " ") << "\""
+           << (buffer->getFilePath().empty() ? "[No Name]" : buffer->getFilePath()) << "\" ";
+        if (buffer->isResident()) {
+            ss << formatBytes(buffer->getResidentBytes());
+        } else {
+            ss << "unloaded";
+        }
+    }
+    return ss.str();
+}
+
+std::string Editor::listJobs() const {
+    if (!threadPool_) return "No thread pool";
+    
+    ThreadPool::Stats stats = threadPool_->getStats();
+    std::stringstream ss;
+    ss << "workers " << stats.workers << ", jobs " << stats.submitted << " ("
+       << stats.completed << " done, " << stats.cancelled << " cancelled, "
+       << stats.stolen << " stolen), queued "
+       << stats.queued[ThreadPool::PRIORITY_INTERACTIVE] << " interactive, "
+       << stats.queued[ThreadPool::PRIORITY_VIEWPORT] << " viewport, "
+       << stats.queued[ThreadPool::PRIORITY_BACKGROUND] << " background";
+    return ss.str();
+}
+
+Settings* Editor::getSettings() {
+    return config_ ? &config_->getSettings() : nullptr;
+}
+
+void Editor::showHelp() {
+    state_.statusMessage = "Commands: :w [file] :q :wq :e file :n :N :ls :jobs :set [option] :recover :dropswap";
+}
+
+bool Editor::recoverSwap() {
+    auto buffer = getCurrentBuffer();
+    if (!buffer || buffer->getFilePath().empty() || buffer->getJournal()) {
+        state_.statusMessage = "No swap file to recover";
+        return false;
+    }
+    
+    int recovered = 0;
+    Result result = Journal::replay(buffer->getFilePath(), *buffer, recovered);
+    if (result.isError()) {
+        state_.statusMessage = result.getError();
+        return false;
+    }
+    
+    // Keep appending to the same swap file: it still applies to the file on disk
+    attachJournal(buffer, true);
+    std::stringstream ss;
+    ss << "Recovered " << recovered << " changes from " << Journal::swapPathFor(buffer->getFilePath());
+    state_.statusMessage = ss.str();
+    return true;
+}
+
+bool Editor::discardSwap() {
+    auto buffer = getCurrentBuffer();
+    if (!buffer || buffer->getFilePath().empty() || buffer->getJournal()) {
+        state_.statusMessage = "No swap file to delete";
+        return false;
+    }
+    
+    // The leftover's records are dropped; a journal for this session (if
+    // swap files are on) starts again from an empty swap file in its place
+    std::string swapPath = Journal::swapPathFor(buffer->getFilePath());
+    attachJournal(buffer, false);
+    if (buffer->getJournal()) {
+        state_.statusMessage = "Discarded old edits in " + swapPath + "; it now journals this session";
+    } else if (unlink(swapPath.c_str()) == 0) {
+        state_.statusMessage = "Deleted " + swapPath;
+    } else {
+        state_.statusMessage = "Cannot delete " + swapPath + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void Editor::attachJournal(const std::shared_ptr<Buffer>& buffer, bool append) {
+    if (!journalWriter_ || buffer->getFilePath().empty()) return;
+    
+    std::shared_ptr<Journal> journal = std::make_shared<Journal>(buffer->getFilePath());
+    if (journal->open(append)) {
+        buffer->setJournal(journal);
+        journalWriter_->addJournal(journal);
+    }
+}
+
 void Editor::backspaceCommandBuffer() {
     if (!state_.commandBuffer.empty()) {
         state_.commandBuffer.pop_back();
@@ -396,10 +1255,11 @@ void Editor::insertLineBelow() {
         int row = cursor_.getRow();
         
         // Insert an empty line after the current line
-        auto& lines = const_cast<std::vector<std::string>&>(buffer->getLines());
-        if (row >= 0 && row < static_cast<int>(lines.size())) {
+        if (row >= 0 && row < static_cast<int>(buffer->getLines().size())) {
+            std::vector<std::string>& lines = buffer->getMutableLines();
             lines.insert(lines.begin() + row + 1, "");
             buffer->setModified(true);
+            buffer->noteEdit(EDIT_INSERT_LINE, row + 1, 0);
             
             // Move cursor to the beginning of the new line
             cursor_.setRow(row + 1);
@@ -415,10 +1275,11 @@ void Editor::insertLineAbove() {
         int row = cursor_.getRow();
         
         // Insert an empty line before the current line
-        auto& lines = const_cast<std::vector<std::string>&>(buffer->getLines());
-        if (row >= 0 && row < static_cast<int>(lines.size())) {
+        if (row >= 0 && row < static_cast<int>(buffer->getLines().size())) {
+            std::vector<std::string>& lines = buffer->getMutableLines();
             lines.insert(lines.begin() + row, "");
             buffer->setModified(true);
+            buffer->noteEdit(EDIT_INSERT_LINE, row, 0);
             
             // Keep the cursor at the same row (which is now the new empty line)
             cursor_.setCol(0);
@@ -426,13 +1287,212 @@ void Editor::insertLineAbove() {
     }
 }
 
+void Editor::applyOperator(char op, const Range& range, bool linewise) {
+    auto buffer = getCurrentBuffer();
+    if (!buffer) return;
+    
+    if (linewise) {
+        int lastRow = static_cast<int>(buffer->getLines().size()) - 1;
+        int first = std::max(0, std::min(range.start.row, range.end.row));
+        int last = std::min(lastRow, std::max(range.start.row, range.end.row));
+        if (first > last) return;
+        
+        const std::vector<std::string>& lines = buffer->getLines();
+        register_.assign(lines.begin() + first, lines.begin() + last + 1);
+        registerLinewise_ = true;
+        
+        if (op == 'd') {
+            BufferUtils::deleteLines(*buffer, first, last - first + 1);
+            int row = std::min(first, static_cast<int>(buffer->getLines().size()) - 1);
+            cursor_.setPosition(row, Motions::firstNonBlank(*buffer, row));
+        } else if (op == 'c') {
+            // Leave one empty line to type into; inserting first keeps the
+            // buffer from ever being empty in between
+            BufferUtils::insertLines(*buffer, first, std::vector<std::string>(1, std::string()));
+            BufferUtils::deleteLines(*buffer, first + 1, last - first + 1);
+            cursor_.setPosition(first, 0);
+            setMode(Mode::INSERT);
+        } else {
+            cursor_.setRow(first);
+        }
+        return;
+    }
+    
+    Range span = range;
+    if (span.end.row < span.start.row ||
+        (span.end.row == span.start.row && span.end.col < span.start.col)) {
+        std::swap(span.start, span.end);
+    }
+    
+    std::string text = BufferUtils::getText(*buffer, span);
+    if (!text.empty()) {
+        register_ = BufferUtils::splitLines(text);
+        registerLinewise_ = false;
+        if (op != 'y') {
+            BufferUtils::deleteText(*buffer, span);
+        }
+    }
+    
+    cursor_.setPosition(span.start.row, span.start.col);
+    cursor_.limitToValidPosition(buffer);
+    if (op == 'c') {
+        setMode(Mode::INSERT);
+    }
+}
+
+void Editor::put(bool after, int count) {
+    auto buffer = getCurrentBuffer();
+    if (!buffer || register_.empty()) return;
+    
+    int row = cursor_.getRow();
+    if (registerLinewise_) {
+        std::vector<std::string> lines;
+        lines.reserve(register_.size() * count);
+        for (int i = 0; i < count; ++i) {
+            lines.insert(lines.end(), register_.begin(), register_.end());
+        }
+        int target = after ? row + 1 : row;
+        BufferUtils::insertLines(*buffer, target, lines);
+        cursor_.setPosition(target, Motions::firstNonBlank(*buffer, target));
+        return;
+    }
+    
+    std::string piece = join(register_, "\n");
+    std::string text;
+    text.reserve(piece.size() * count);
+    for (int i = 0; i < count; ++i) {
+        text += piece;
+    }
+    
+    int length = BufferUtils::getLineLength(*buffer, row);
+    int col = std::min(cursor_.getCol(), length);
+    if (after && length > 0) {
+        col = BufferUtils::nextCharStart(*buffer, row, col);
+    }
+    BufferUtils::insertText(*buffer, row, col, text);
+    
+    // Single-line text leaves the cursor on its last character
+    if (register_.size() == 1) {
+        cursor_.setPosition(row, BufferUtils::prevCharStart(*buffer, row, col + static_cast<int>(text.size())));
+    } else {
+        cursor_.setPosition(row, col);
+    }
+}
+
+void Editor::joinLines(int count) {
+    auto buffer = getCurrentBuffer();
+    if (!buffer) return;
+    
+    const std::vector<std::string>& lines = buffer->getLines();
+    int row = cursor_.getRow();
+    int last = std::min(static_cast<int>(lines.size()) - 1, row + std::max(2, count) - 1);
+    if (row < 0 || row >= last) return;
+    
+    // Separate the joined lines with one space, dropping their indentation
+    std::string joined = lines[row];
+    int col = 0;
+    for (int i = row + 1; i <= last; ++i) {
+        const std::string& next = lines[i];
+        size_t start = next.find_first_not_of(" \t");
+        col = static_cast<int>(joined.size());
+        if (start == std::string::npos) continue;
+        if (!joined.empty() && joined[joined.size() - 1] != ' ' && next[start] != ')') {
+            joined += ' ';
+        }
+        joined.append(next, start, std::string::npos);
+    }
+    
+    BufferUtils::insertLines(*buffer, row, std::vector<std::string>(1, joined));
+    BufferUtils::deleteLines(*buffer, row + 1, last - row + 1);
+    cursor_.setPosition(row, col);
+}
+
+void Editor::insertAtCursor(const std::string& text) {
+    auto buffer = getCurrentBuffer();
+    if (!buffer || text.empty()) return;
+    
+    cursor_.limitToValidPosition(buffer);
+    int row = cursor_.getRow();
+    int col = cursor_.getCol();
+    BufferUtils::insertText(*buffer, row, col, text);
+    
+    size_t lastNewline = text.rfind('\n');
+    if (lastNewline == std::string::npos) {
+        cursor_.setPosition(row, col + static_cast<int>(text.size()));
+    } else {
+        int newlines = static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+        cursor_.setPosition(row + newlines, static_cast<int>(text.size() - lastNewline - 1));
+    }
+}
+
+void Editor::startRecording(char reg) {
+    if (!isalnum(static_cast<unsigned char>(reg))) {
+        state_.statusMessage = "Invalid register";
+        return;
+    }
+    
+    // "qA" appends to register a
+    recordingRegister_ = static_cast<char>(tolower(static_cast<unsigned char>(reg)));
+    if (!isupper(static_cast<unsigned char>(reg))) {
+        macros_[recordingRegister_].clear();
+    }
+    state_.statusMessage.clear();
+}
+
+void Editor::stopRecording() {
+    recordingRegister_ = 0;
+    state_.statusMessage.clear();
+}
+
+bool Editor::isRecording() const {
+    return recordingRegister_ != 0;
+}
+
+void Editor::replayMacro(char reg, int count) {
+    if (reg == '@') {
+        reg = lastMacro_;
+    }
+    reg = static_cast<char>(tolower(static_cast<unsigned char>(reg)));
+    
+    std::map<char, std::vector<KeyInput> >::const_iterator macro = macros_.find(reg);
+    if (macro == macros_.end() || macro->second.empty()) {
+        state_.statusMessage = "Register empty";
+        return;
+    }
+    // A macro that calls itself would never finish
+    if (replayDepth_ >= 100 || reg == recordingRegister_) {
+        state_.statusMessage = "Macro recursion too deep";
+        return;
+    }
+    lastMacro_ = reg;
+    
+    // Straight into the key handlers: no status line or screen updates until
+    // the whole replay is done. Copy, since the macro may rewrite registers.
+    std::vector<KeyInput> keys = macro->second;
+    ++replayDepth_;
+    for (int i = 0; i < count && !state_.quit; ++i) {
+        for (size_t k = 0; k < keys.size(); ++k) {
+            handleInput(keys[k]);
+        }
+    }
+    --replayDepth_;
+}
+
 void Editor::setMode(Mode newMode) {
+    if (state_.mode == Mode::INSERT && newMode != Mode::INSERT) {
+        hotkeyManager_->finishInsert(insertedText_);
+    } else if (newMode == Mode::INSERT && state_.mode != Mode::INSERT) {
+        insertedText_.clear();
+    }
     state_.mode = newMode;
 }
 
-std::string Editor::getModeString(Mode mode) const {
-    // Use if-else instead of switch for enum class
-    // Now that Mode is a plain enum, switch is fine, but if-else also works
+Mode Editor::getMode() const {
+    return state_.mode;
+}
+
+// Literals, so the status line can tell a mode change by the pointer
+static const char* modeName(Mode mode) {
     if (mode == NORMAL) return "NORMAL";
     else if (mode == INSERT) return "INSERT";
     else if (mode == VISUAL) return "VISUAL";
@@ -441,31 +1501,29 @@ std::string Editor::getModeString(Mode mode) const {
     else return "UNKNOWN";
 }
 
-void Editor::updateStatusLine() {
-    auto buffer = getCurrentBuffer();
+std::string Editor::getModeString(Mode mode) const {
+    return modeName(mode);
+}
+
+void Editor::updateStatusLine() const {
+    auto buffer = tabManager_->getCurrentBuffer();
     if (!buffer) return;
     
-    std::stringstream ss;
-    ss << "[" << getModeString(state_.mode) << "] ";
+    statusLine_.setMode(modeName(state_.mode));
+    statusLine_.setFile(buffer->getFilePath(), buffer->isModified());
+    statusLine_.setSaveProgress(asyncSaver_ && asyncSaver_->isBusy() ? asyncSaver_->getProgress() : -1);
+    statusLine_.setRecording(recordingRegister_);
+    statusLine_.setPosition(cursor_.getRow(), buffer->getLines().size(),
+                            buffer->getDisplayColumn(cursor_.getRow(), cursor_.getCol(), getTabSize()));
+    statusLine_.setMessage(state_.statusMessage);
     
-    if (!buffer->getFilePath().empty()) {
-        ss << buffer->getFilePath();
+    if (isShowingPerf()) {
+        char perf[128];
+        perfStats_.format(perf, sizeof(perf));
+        statusLine_.setPerf(perf);
     } else {
-        ss << "[No Name]";
-    }
-    
-    if (buffer->isModified()) {
-        ss << " [+]";
-    }
-    
-    ss << " - Line " << (cursor_.getRow() + 1) << "/" << buffer->getLines().size()
-       << " Col " << (cursor_.getCol() + 1);
-    
-    if (!state_.statusMessage.empty()) {
-        ss << " | " << state_.statusMessage;
+        statusLine_.setPerf("");
     }
-    
-    state_.statusMessage = ss.str();
 }
 
 void Editor::setupNormalModeBindings() {
@@ -492,7 +1550,22 @@ void Editor::handleOperation(const KeyInput& input) {
     // This is a placeholder; actual implementation is in HotkeyManager
 }
 
+const std::shared_ptr<Buffer>& Editor::getCurrentBuffer() {
+    static const std::shared_ptr<Buffer> none;
+    return tabManager_ ? tabManager_->getCurrentBuffer() : none;
+}
+
 void Editor::cleanup() {
+    // Let a pending background save reach the disk
+    if (asyncSaver_) {
+        asyncSaver_->wait();
+    }
+    
+    if (config_ && settingsListener_ >= 0) {
+        config_->getSettings().removeListener(settingsListener_);
+        settingsListener_ = -1;
+    }
+    
     // Save any unsaved buffers that need to be saved
     auto buffer = getCurrentBuffer();
     if (buffer && buffer->isModified()) {
@@ -5,8 +5,13 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <ctime>
+#include <functional>
 #include "terminal.h"
 #include "cursor.h"
+#include "statusline.h"
+#include "viewport.h"
+#include "../utils/perfstats.h"
 
 namespace cvim {
 
@@ -16,6 +21,15 @@ class CommandProcessor;
 class FileTree;
 class TabManager;
 class HotkeyManager;
+class AsyncSaver;
+class Journal;
+class JournalWriter;
+class BufferRegistry;
+class FileWatcher;
+class ThreadPool;
+class Settings;
+class ColumnIndex;
+struct ColumnMark;
 
 enum Mode { // Changed from enum class
     NORMAL,
@@ -25,6 +39,22 @@ enum Mode { // Changed from enum class
     COMMAND
 };
 
+// Primitive buffer edits, as recorded in the crash-recovery journal.
+// Values are stored in swap files; only append new ones.
+enum EditOp {
+    EDIT_INSERT_CHAR = 1,
+    EDIT_DELETE_CHAR = 2,
+    EDIT_LINE_BREAK = 3,
+    EDIT_JOIN_LINES = 4,
+    EDIT_INSERT_LINE = 5,
+    EDIT_DELETE_LINE = 6,
+    EDIT_DELETE_LINES = 7,
+    EDIT_INSERT_TEXT = 8,
+    EDIT_DELETE_TEXT = 9,
+    EDIT_INSERT_LINES = 10,
+    EDIT_REPLACE_LINES = 11
+};
+
 class Buffer {
 public:
     Buffer(const std::string& filePath = "");
@@ -40,14 +70,84 @@ public:
     void deleteChar(int pos, int line);
     
     const std::vector<std::string>& getLines() const;
+    std::vector<std::string>& getMutableLines();
     const std::string& getFilePath() const;
+    void setFilePath(const std::string& filePath);
     bool isModified() const;
     void setModified(bool modified);
     
+    // Immutable view of the current contents for background readers; the
+    // next mutation copies the lines instead of touching the snapshot
+    std::shared_ptr<const std::vector<std::string> > snapshot() const;
+    // Take over copy, made from source off the input path, if the lines
+    // are still source; the next edit then has nothing to copy
+    void adoptCopy(const std::shared_ptr<const std::vector<std::string> >& source,
+                   const std::shared_ptr<std::vector<std::string> >& copy);
+    
+    // Every mutation reports itself here after changing the lines
+    void noteEdit(EditOp op, int row, int col, const std::string& text = std::string());
+    
+    // Crash-recovery journal, if this buffer has one
+    void setJournal(const std::shared_ptr<Journal>& journal);
+    std::shared_ptr<Journal> getJournal() const;
+    
+    // Memory budgeting: an evicted buffer keeps only its path and is read
+    // back in by ensureLoaded(). Only unmodified file buffers evict.
+    bool canEvict() const;
+    void evict();
+    bool isResident() const;
+    bool ensureLoaded();
+    size_t getResidentBytes() const;
+    
+    // Screen columns (see unicode.h): where byte col of row is drawn, the
+    // byte drawn at a display column, and the width of the whole row. Long
+    // lines keep a ColumnIndex, which an edit on the line only trims.
+    int getDisplayColumn(int row, int col, int tabSize) const;
+    int getByteColumn(int row, int displayCol, int tabSize) const;
+    // getByteColumn() with the display column that byte is drawn at
+    ColumnMark getColumnMark(int row, int displayCol, int tabSize) const;
+    int getDisplayWidth(int row, int tabSize) const;
+    // Soft wrap at width cells (see wrapLine): how many screen rows the
+    // line takes, where one of them starts, and the one byte col is on.
+    // Rows are laid out only as far as asked, so prefer hasWrapRow() to
+    // the count on long lines.
+    int getWrapRowCount(int row, int width, int tabSize) const;
+    bool hasWrapRow(int row, int wrapRow, int width, int tabSize) const;
+    ColumnMark getWrapRowStart(int row, int wrapRow, int width, int tabSize) const;
+    int getWrapRow(int row, int col, int width, int tabSize) const;
+    
+    // Remember the file's mtime after this buffer read or wrote it
+    void refreshDiskMtime();
+    // True (once) if someone else wrote the file since then
+    bool changedOnDisk();
+    
+    // Incremented on every modification
+    unsigned long getChangeTick() const;
+    // Clear the modified flag only if nothing changed since changeTick
+    void markSaved(unsigned long changeTick);
+    
 private:
     std::string filePath_;
-    std::vector<std::string> lines_;
+    std::shared_ptr<std::vector<std::string> > lines_;
     bool modified_;
+    unsigned long changeTick_;
+    std::shared_ptr<Journal> journal_;
+    bool resident_;
+    long long diskMtime_; // nanoseconds
+    mutable size_t residentBytes_;
+    mutable unsigned long residentBytesTick_;
+    
+    // Lines up to minLength bytes get no index
+    const ColumnIndex* getColumnIndex(int row, int tabSize, size_t minLength) const;
+    // Null when the line fits on one row; otherwise laid out at least as
+    // far as ColumnIndex::getRows() is asked to
+    const std::vector<ColumnMark>* getWrapRows(int row, int width, int tabSize,
+                                               size_t minRows, size_t minByte) const;
+    void updateColumnIndex(EditOp op, int row, int col, const std::string& text);
+    // One entry per line, null until a long line is first measured
+    mutable std::vector<std::shared_ptr<ColumnIndex> > columnIndex_;
+    mutable unsigned long columnIndexTick_;
+    mutable int columnIndexTabSize_;
 };
 
 struct EditorState {
@@ -64,28 +164,99 @@ public:
     Editor();
     ~Editor();
     
+    // Without a terminal the editor runs headless: no swap files, no file
+    // watching, and :w writes synchronously
     void initialize(Terminal* terminal, Config* config);
     void handleInput(const KeyInput& input);
     
     bool openFile(const std::string& filePath);
     bool saveFile();
     bool saveFileAs(const std::string& filePath);
+    bool saveFileInBackground(const std::string& filePath = "");
+    
+    // Poll background work (saves, key sequence timeouts); true if
+    // anything visible changed
+    bool processBackgroundTasks();
+    // True while background work needs processBackgroundTasks() called
+    bool hasPendingWork() const;
+    // Called from worker threads when they finish something
+    void setWakeup(std::function<void()> wakeup);
+    // Shared pool for background jobs; completions run in processBackgroundTasks()
+    ThreadPool* getThreadPool() const { return threadPool_; }
+    
+    // Files changed by other programs: poll getWatchFd(), then call
+    // handleFileChanges(); true if the status line changed
+    int getWatchFd() const;
+    bool handleFileChanges();
+    
+    // Startup work deferred until after the first frame: reads the config
+    // file, starts the thread pool and background saver, then watches the
+    // config. Call once the config path is final.
+    void finishStartup();
+    
+    // Re-parse the config file on the thread pool and swap in what changed,
+    // without interrupting editing; called when the watched file changes
+    void reloadConfig();
     
-    ViewData getViewData() const;
+    // Created on first use
+    FileTree* getFileTree();
+    
+    // The next frame; valid until the next call, which reuses its strings
+    const ViewData& getViewData() const;
     bool shouldQuit() const;
     
+    // What the last frame showed; gj and gk move by its rows
+    const Viewport& getViewport() const { return viewport_; }
+    
+    // zl / zh: scroll the view sideways, moving the cursor only if it
+    // would leave the screen
+    void scrollColumns(int columns);
+    
+    // Columns a tab advances to; from the tabSize setting
+    int getTabSize() const;
+    
+    // :set showperf appends the figures of the last frame to the status
+    // line; the main loop times its frames only while this is on
+    bool isShowingPerf() const;
+    void recordFrame(long long inputLatencyNs, long long frameNs, long long frameBytes);
+    
     // Added accessor methods
     Cursor& getCursor() { return cursor_; }
     const Cursor& getCursor() const { return cursor_; }
-    std::shared_ptr<Buffer> getCurrentBuffer();
+    const std::shared_ptr<Buffer>& getCurrentBuffer();
     
     // Mode handling
     void setMode(Mode newMode);
+    Mode getMode() const;
     std::string getModeString(Mode mode) const;
     
     // Command handling
     void executeCommand();
     void clearCommandBuffer();
+    void setStatusMessage(const std::string& message);
+    const std::string& getStatusMessage() const;
+    void requestQuit();
+    // True if any open buffer has changes not yet written
+    bool hasUnsavedChanges() const;
+    // Forget a quit request, e.g. between files of a batch run
+    void cancelQuit();
+    
+    // Buffer list navigation (:n, :N, :buffers)
+    void nextBuffer();
+    void prevBuffer();
+    // Drop the current buffer without saving it
+    void closeBuffer();
+    std::string listBuffers() const;
+    // Thread pool counters (:jobs)
+    std::string listJobs() const;
+    
+    // Typed options (:set); null when running without a config
+    Settings* getSettings();
+    void showHelp();
+    
+    // Crash recovery for the current buffer's leftover swap file
+    bool recoverSwap();
+    bool discardSwap();
     void backspaceCommandBuffer();
     void appendToCommandBuffer(char c);
     
@@ -101,6 +272,24 @@ public:
     void insertLineBelow();
     void insertLineAbove();
     
+    // Operators d, c and y over a charwise range (exclusive end) or, when
+    // linewise, the whole rows from range.start.row to range.end.row
+    void applyOperator(char op, const Range& range, bool linewise);
+    // p / P from the unnamed register, count copies in one insertion
+    void put(bool after, int count);
+    // J: join count lines (at least two) into the cursor line
+    void joinLines(int count);
+    // Insert text (possibly several lines) at the cursor as one edit and
+    // leave the cursor after it, as typing it would
+    void insertAtCursor(const std::string& text);
+    
+    // Macros: q{reg} records keys until the next q, @{reg} replays them.
+    // An upper-case register appends; @@ repeats the last macro.
+    void startRecording(char reg);
+    void stopRecording();
+    bool isRecording() const;
+    void replayMacro(char reg, int count);
+    
     // Resource cleanup
     void cleanup();
     
@@ -111,7 +300,10 @@ private:
     void handleCommandMode(const KeyInput& input);
     
     void executeCommand(const std::string& command);
-    void updateStatusLine();
+    // Bring the status line segments up to date; done for every frame
+    void updateStatusLine() const;
+    // Watch the config file and apply its key bindings
+    void watchConfig();
     
     void setupNormalModeBindings();
     void setupInsertModeBindings();
@@ -120,6 +312,10 @@ private:
     
     void handleMovement(const KeyInput& input);
     void handleOperation(const KeyInput& input);
+    void attachJournal(const std::shared_ptr<Buffer>& buffer, bool append);
+    // An evicted buffer that could not be read back in is never written
+    bool checkResident(const std::shared_ptr<Buffer>& buffer);
+    void reportUnloaded(const std::shared_ptr<Buffer>& buffer);
     
     Terminal* terminal_;
     Config* config_;
@@ -129,6 +325,31 @@ private:
     FileTree* fileTree_;
     EditorState state_;
     HotkeyManager* hotkeyManager_;
+    AsyncSaver* asyncSaver_;
+    JournalWriter* journalWriter_;
+    BufferRegistry* bufferRegistry_;
+    FileWatcher* fileWatcher_;
+    ThreadPool* threadPool_;
+    int settingsListener_;
+    unsigned configGeneration_; // newest config reload; older results are dropped
+    std::function<void()> wakeup_;
+    
+    // Unnamed register for yank, delete and put
+    std::vector<std::string> register_;
+    bool registerLinewise_;
+    
+    // Text typed since entering insert mode, for "."
+    std::string insertedText_;
+    
+    std::map<char, std::vector<KeyInput> > macros_;
+    char recordingRegister_;
+    char lastMacro_;
+    int replayDepth_;
+    
+    PerfStats perfStats_;
+    mutable StatusLine statusLine_;
+    mutable Viewport viewport_; // scrolled to the cursor by getViewData()
+    mutable ViewData viewData_;
 };
 
 } // namespace cvim
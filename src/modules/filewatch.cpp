@@ -0,0 +1,64 @@
+#include "filewatch.h"
+#include "../utils/utils.h"
+#include <algorithm>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+namespace cvim {
+
+FileWatcher::FileWatcher() {
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+FileWatcher::~FileWatcher() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+int FileWatcher::getFd() const {
+    return fd_;
+}
+
+bool FileWatcher::watch(const std::string& filePath) {
+    if (fd_ < 0 || filePath.empty()) return false;
+
+    std::string directory = getDirectoryPath(filePath);
+    if (directory.empty()) {
+        directory = ".";
+    }
+    if (watches_.count(directory)) return true;
+
+    // In-place writes end in IN_CLOSE_WRITE, atomic saves in IN_MOVED_TO
+    int wd = inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) return false;
+
+    watches_[directory] = wd;
+    directories_[wd] = directory;
+    return true;
+}
+
+std::vector<std::string> FileWatcher::readChanges() {
+    std::vector<std::string> changed;
+    if (fd_ < 0) return changed;
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    while ((length = read(fd_, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            std::map<int, std::string>::const_iterator directory = directories_.find(event->wd);
+            if (directory == directories_.end() || event->len == 0) continue;
+
+            std::string path = directory->second + "/" + event->name;
+            if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                changed.push_back(path);
+            }
+        }
+    }
+    return changed;
+}
+
+} // namespace cvim
@@ -0,0 +1,35 @@
+#ifndef CVIM_FILEWATCH_H
+#define CVIM_FILEWATCH_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace cvim {
+
+// Reports files written by other programs, through inotify. Watches the
+// containing directory rather than the file, since an atomic save replaces
+// the file (and its inode) with a rename.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    // Descriptor to poll for events, or -1 if inotify is unavailable
+    int getFd() const;
+
+    bool watch(const std::string& filePath);
+
+    // Paths (as directory + "/" + name) written or replaced since the last
+    // call; empty if nothing happened
+    std::vector<std::string> readChanges();
+
+private:
+    int fd_;
+    std::map<int, std::string> directories_;
+    std::map<std::string, int> watches_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_FILEWATCH_H
@@ -0,0 +1,46 @@
+#include "gutter.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace cvim {
+
+Gutter::Gutter() : numbers_(false), relative_(false) {}
+
+void Gutter::setMode(bool numbers, bool relative) {
+    numbers_ = numbers;
+    relative_ = relative;
+}
+
+int Gutter::getWidth(size_t lineCount) const {
+    if (!isVisible()) return 0;
+    int digits = 1;
+    for (size_t count = lineCount; count >= 10; count /= 10) {
+        ++digits;
+    }
+    return (digits < 3 ? 3 : digits) + 1;
+}
+
+void Gutter::append(int line, int cursorLine, bool firstRow, int width, std::string& out) const {
+    if (width <= 0) return;
+    if (!firstRow) {
+        out.append(width, ' ');
+        return;
+    }
+    
+    int number = line + 1;
+    if (relative_ && line != cursorLine) {
+        number = abs(line - cursorLine);
+    } else if (relative_ && !numbers_) {
+        number = 0;
+    }
+    
+    char digits[16];
+    int length = snprintf(digits, sizeof(digits), "%d", number);
+    if (width - 1 > length) {
+        out.append(width - 1 - length, ' ');
+    }
+    out.append(digits, length);
+    out += ' ';
+}
+
+} // namespace cvim
@@ -0,0 +1,34 @@
+#ifndef CVIM_GUTTER_H
+#define CVIM_GUTTER_H
+
+#include <string>
+#include <cstddef>
+
+namespace cvim {
+
+// Line numbers left of the text. The width follows the line count (three
+// digits at least, as in Vim), so it only changes when the count crosses a
+// power of ten. With relative numbers the other rows show their distance
+// from the cursor line, and the cursor line its own number, or 0 when
+// absolute numbers are off.
+class Gutter {
+public:
+    Gutter();
+
+    void setMode(bool numbers, bool relative);
+    bool isVisible() const { return numbers_ || relative_; }
+
+    // Cells taken, the separating blank included; 0 when hidden
+    int getWidth(size_t lineCount) const;
+    // Append the cells of a screen row showing line; the rows a wrapped
+    // line continues on get blanks
+    void append(int line, int cursorLine, bool firstRow, int width, std::string& out) const;
+
+private:
+    bool numbers_;
+    bool relative_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_GUTTER_H
@@ -1,13 +1,30 @@
 #include "hotkeys.h"
 #include "editor.h" // Includes Mode enum definition
 #include "buffer_utils.h"
+#include "motions.h"
+#include "../config/config.h"
+#include "../utils/profiler.h"
 #include <functional>
+#include <algorithm>
+#include <cstring>
 
 namespace cvim {
 
-HotkeyManager::HotkeyManager() : editor_(nullptr) {}
+// Larger counts are clamped rather than overflowing
+static const int MAX_COUNT = 99999999;
 
-HotkeyManager::HotkeyManager(Editor* editor) : editor_(editor) {
+HotkeyManager::HotkeyManager()
+    : editor_(nullptr), tablesDirty_(true), pendingCount_(0), pendingOperator_(0),
+      operatorCount_(0), node_(KeyTrie::ROOT), awaitingChar_(KeyTrie::NONE), timeoutMs_(1000),
+      repeating_(false) {
+    lastChange_.sequence = KeyTrie::NONE;
+}
+
+HotkeyManager::HotkeyManager(Editor* editor)
+    : editor_(editor), tablesDirty_(true), pendingCount_(0), pendingOperator_(0),
+      operatorCount_(0), node_(KeyTrie::ROOT), awaitingChar_(KeyTrie::NONE), timeoutMs_(1000),
+      repeating_(false) {
+    lastChange_.sequence = KeyTrie::NONE;
     setupDefaultBindings();
 }
 
@@ -20,136 +37,835 @@ void HotkeyManager::setEditor(Editor* editor) {
 
 void HotkeyManager::addNormalModeBinding(Key key, std::function<void()> action) {
     keyBindings_[static_cast<int>(Mode::NORMAL)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addNormalModeBinding(char key, std::function<void()> action) {
     charBindings_[static_cast<int>(Mode::NORMAL)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addVisualModeBinding(Key key, std::function<void()> action) {
     keyBindings_[static_cast<int>(Mode::VISUAL)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addVisualModeBinding(char key, std::function<void()> action) {
     charBindings_[static_cast<int>(Mode::VISUAL)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addInsertModeBinding(Key key, std::function<void()> action) {
     keyBindings_[static_cast<int>(Mode::INSERT)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addInsertModeBinding(char key, std::function<void()> action) {
     charBindings_[static_cast<int>(Mode::INSERT)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addCommandModeBinding(Key key, std::function<void()> action) {
     keyBindings_[static_cast<int>(Mode::COMMAND)][key] = action;
+    tablesDirty_ = true;
 }
 
 void HotkeyManager::addCommandModeBinding(char key, std::function<void()> action) {
     charBindings_[static_cast<int>(Mode::COMMAND)][key] = action;
+    tablesDirty_ = true;
+}
+
+void HotkeyManager::addMotion(const std::string& keys, MotionFn motion, bool takesChar) {
+    Sequence sequence;
+    sequence.kind = SEQ_MOTION;
+    sequence.op = 0;
+    sequence.takesChar = takesChar;
+    sequence.change = false;
+    sequence.motion = motion;
+    addSequence(keys, sequence, true);
+}
+
+void HotkeyManager::addOperator(char key) {
+    Sequence sequence;
+    sequence.kind = SEQ_OPERATOR;
+    sequence.op = key;
+    sequence.takesChar = false;
+    sequence.change = false;
+    addSequence(std::string(1, key), sequence, false);
+}
+
+void HotkeyManager::addTextObject(const std::string& keys, TextObjectFn textObject) {
+    Sequence sequence;
+    sequence.kind = SEQ_TEXT_OBJECT;
+    sequence.op = 0;
+    sequence.takesChar = false;
+    sequence.change = false;
+    sequence.textObject = textObject;
+    addSequence(keys, sequence, true);
+}
+
+void HotkeyManager::addNormalModeSequence(const std::string& keys, CommandFn command, bool takesChar) {
+    Sequence sequence;
+    sequence.kind = SEQ_COMMAND;
+    sequence.op = 0;
+    sequence.takesChar = takesChar;
+    sequence.change = false;
+    sequence.command = command;
+    addSequence(keys, sequence, false);
+}
+
+void HotkeyManager::addChangeCommand(const std::string& keys, CommandFn command, bool takesChar) {
+    Sequence sequence;
+    sequence.kind = SEQ_COMMAND;
+    sequence.op = 0;
+    sequence.takesChar = takesChar;
+    sequence.change = true;
+    sequence.command = command;
+    addSequence(keys, sequence, false);
+}
+
+int HotkeyManager::addSequence(const std::string& keys, const Sequence& sequence, bool operatorPending) {
+    sequences_.push_back(sequence);
+    int id = static_cast<int>(sequences_.size()) - 1;
+    sequences_[id].keys = keys;
+    sequences_[id].operatorPending = operatorPending;
+    
+    if (!keys.empty()) {
+        bindSequence(keys, id);
+    }
+    return id;
+}
+
+void HotkeyManager::bindSequence(const std::string& keys, int sequenceId) {
+    // Motions are valid on their own and after an operator; text objects
+    // only after one, operators and commands only on their own
+    const Sequence& sequence = sequences_[sequenceId];
+    if (sequence.kind != SEQ_TEXT_OBJECT) {
+        normalTrie_.insert(keys, sequenceId);
+    }
+    if (sequence.operatorPending) {
+        operatorTrie_.insert(keys, sequenceId);
+    }
+}
+
+int HotkeyManager::findSequence(const std::string& keys) const {
+    // Text objects only live in the operator-pending trie
+    const KeyTrie* tries[] = { &normalTrie_, &operatorTrie_ };
+    for (int t = 0; t < 2; ++t) {
+        int node = KeyTrie::ROOT;
+        for (size_t i = 0; i < keys.size() && node != KeyTrie::NONE; ++i) {
+            node = tries[t]->step(node, keys[i]);
+        }
+        if (node != KeyTrie::NONE && tries[t]->actionAt(node) != KeyTrie::NONE) {
+            return tries[t]->actionAt(node);
+        }
+    }
+    return KeyTrie::NONE;
+}
+
+void HotkeyManager::addAction(const std::string& name, const std::string& keys) {
+    int sequenceId = findSequence(keys);
+    if (sequenceId != KeyTrie::NONE) {
+        actions_[name] = sequenceId;
+    }
+}
+
+void HotkeyManager::addAction(const std::string& name, CommandFn command, bool change) {
+    Sequence sequence;
+    sequence.kind = SEQ_COMMAND;
+    sequence.op = 0;
+    sequence.takesChar = false;
+    sequence.change = change;
+    sequence.command = command;
+    actions_[name] = addSequence("", sequence, false);
+}
+
+bool HotkeyManager::applyKeyBindings(const std::vector<KeyBinding>& bindings, std::string& error) {
+    // Start over from the defaults, so removed bindings disappear; the
+    // sequences themselves stay, and with them the change "." repeats
+    resetPending();
+    normalTrie_.clear();
+    operatorTrie_.clear();
+    for (size_t i = 0; i < sequences_.size(); ++i) {
+        if (!sequences_[i].keys.empty()) {
+            bindSequence(sequences_[i].keys, static_cast<int>(i));
+        }
+    }
+    
+    error.clear();
+    for (size_t i = 0; i < bindings.size(); ++i) {
+        const KeyBinding& binding = bindings[i];
+        std::string problem;
+        std::map<std::string, int>::const_iterator action = actions_.find(binding.action);
+        if (binding.mode != "normal") {
+            problem = "unsupported mode \"" + binding.mode + "\"";
+        } else if (binding.key.empty()) {
+            problem = "empty key";
+        } else if (action == actions_.end()) {
+            problem = "unknown action \"" + binding.action + "\"";
+        } else {
+            bindSequence(binding.key, action->second);
+            continue;
+        }
+        if (error.empty()) {
+            error = "Key binding " + binding.key + ": " + problem;
+        }
+    }
+    return error.empty();
+}
+
+const KeyTrie& HotkeyManager::activeTrie() const {
+    return pendingOperator_ ? operatorTrie_ : normalTrie_;
+}
+
+void HotkeyManager::setTimeout(int milliseconds) {
+    timeoutMs_ = std::max(0, milliseconds);
+}
+
+bool HotkeyManager::isPending() const {
+    return pendingCount_ > 0 || pendingOperator_ != 0 || node_ != KeyTrie::ROOT ||
+           awaitingChar_ != KeyTrie::NONE;
+}
+
+const std::string& HotkeyManager::getPendingKeys() const {
+    return pendingKeys_;
+}
+
+void HotkeyManager::resetPending() {
+    pendingCount_ = 0;
+    pendingOperator_ = 0;
+    operatorCount_ = 0;
+    node_ = KeyTrie::ROOT;
+    awaitingChar_ = KeyTrie::NONE;
+    pendingKeys_.clear();
+}
+
+bool HotkeyManager::isWaitingForTimeout() const {
+    return node_ != KeyTrie::ROOT && awaitingChar_ == KeyTrie::NONE;
+}
+
+bool HotkeyManager::checkTimeout() {
+    if (!isWaitingForTimeout()) return false;
+    
+    std::chrono::steady_clock::duration waited = std::chrono::steady_clock::now() - pendingSince_;
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(waited).count() < timeoutMs_) {
+        return false;
+    }
+    
+    // Nothing longer came: settle on the prefix's own binding, if any
+    int action = activeTrie().actionAt(node_);
+    node_ = KeyTrie::ROOT;
+    if (action == KeyTrie::NONE) {
+        resetPending();
+    } else {
+        dispatch(action);
+    }
+    return true;
+}
+
+int HotkeyManager::takeCount() {
+    // d3w and 3dw both delete three words; 2d3w deletes six
+    if (operatorCount_ == 0) return pendingCount_;
+    if (pendingCount_ == 0) return operatorCount_;
+    long long product = static_cast<long long>(operatorCount_) * pendingCount_;
+    return static_cast<int>(std::min<long long>(product, MAX_COUNT));
+}
+
+bool HotkeyManager::handleSequence(char c) {
+    if (awaitingChar_ != KeyTrie::NONE) {
+        int id = awaitingChar_;
+        awaitingChar_ = KeyTrie::NONE;
+        run(id, c);
+        return true;
+    }
+    
+    // Counts; a leading 0 is the motion
+    if (node_ == KeyTrie::ROOT && c >= '0' && c <= '9' && (c != '0' || pendingCount_ > 0)) {
+        pendingCount_ = static_cast<int>(std::min<long long>(pendingCount_ * 10LL + (c - '0'), MAX_COUNT));
+        pendingKeys_ += c;
+        return true;
+    }
+    
+    // dd, cc, yy: count whole lines from the cursor
+    if (pendingOperator_ && node_ == KeyTrie::ROOT && c == pendingOperator_) {
+        char op = pendingOperator_;
+        int count = takeCount();
+        if (op != 'y') {
+            recordChange(KeyTrie::NONE, op, count, 0);
+        }
+        resetPending();
+        applyToLines(op, count);
+        return true;
+    }
+    
+    const KeyTrie& trie = activeTrie();
+    int next = trie.step(node_, c);
+    if (next == KeyTrie::NONE) {
+        if (node_ != KeyTrie::ROOT) {
+            // The sequence broke off: run the prefix if it is bound, then c
+            int action = trie.actionAt(node_);
+            if (action == KeyTrie::NONE) {
+                resetPending();
+                return true;
+            }
+            dispatch(action);
+            return handleSequence(c);
+        }
+        
+        // Nothing starts with c. After an operator that cancels it; otherwise
+        // the key falls through to the single-key bindings.
+        bool swallow = pendingOperator_ != 0;
+        resetPending();
+        return swallow;
+    }
+    
+    node_ = next;
+    if (trie.hasChildren(node_)) {
+        // Wait for the next key, or for the timeout to settle it
+        pendingKeys_ += c;
+        pendingSince_ = std::chrono::steady_clock::now();
+        return true;
+    }
+    dispatch(trie.actionAt(node_));
+    if (isPending()) {
+        // An operator or f/t waiting for more
+        pendingKeys_ += c;
+    }
+    return true;
+}
+
+void HotkeyManager::dispatch(int sequenceId) {
+    node_ = KeyTrie::ROOT;
+    if (sequences_[sequenceId].takesChar) {
+        awaitingChar_ = sequenceId;
+        return;
+    }
+    run(sequenceId, 0);
+}
+
+void HotkeyManager::run(int sequenceId, char arg) {
+    const Sequence& sequence = sequences_[sequenceId];
+    
+    if (sequence.kind == SEQ_OPERATOR) {
+        if (pendingOperator_) {
+            // dy and the like mean nothing
+            resetPending();
+            return;
+        }
+        pendingOperator_ = sequence.op;
+        operatorCount_ = pendingCount_;
+        pendingCount_ = 0;
+        return;
+    }
+    
+    int count = takeCount();
+    
+    // Remember what changes text, for "."; yanks and motions alone don't
+    if ((pendingOperator_ && pendingOperator_ != 'y') || sequence.change) {
+        recordChange(sequenceId, pendingOperator_, count, arg);
+    }
+    
+    switch (sequence.kind) {
+        case SEQ_MOTION: {
+            // Motions start from the cursor clamped into the buffer
+            MotionTarget target;
+            target.position = editor_->getCursor().getPosition();
+            target.linewise = false;
+            target.inclusive = false;
+            target.keepColumn = false;
+            const std::shared_ptr<Buffer>& buffer = editor_->getCurrentBuffer();
+            if (buffer) {
+                int maxRow = static_cast<int>(buffer->getLines().size()) - 1;
+                target.position.row = std::max(0, std::min(target.position.row, maxRow));
+                target.position.col = std::max(0, std::min(target.position.col,
+                    BufferUtils::getLineLength(*buffer, target.position.row)));
+                if (sequence.motion(*buffer, count, arg, target)) {
+                    applyMotion(*buffer, target);
+                }
+            }
+            break;
+        }
+        case SEQ_TEXT_OBJECT: {
+            Range range;
+            bool linewise = false;
+            auto buffer = editor_->getCurrentBuffer();
+            if (buffer && pendingOperator_ && sequence.textObject(*buffer, count, range, linewise)) {
+                char op = pendingOperator_;
+                resetPending();
+                editor_->applyOperator(op, range, linewise);
+            }
+            break;
+        }
+        case SEQ_COMMAND:
+            resetPending();
+            sequence.command(count, arg);
+            break;
+        default:
+            break;
+    }
+    resetPending();
+}
+
+void HotkeyManager::applyToLines(char op, int count) {
+    Range range;
+    range.start.row = editor_->getCursor().getRow();
+    range.start.col = 0;
+    range.end.row = range.start.row + std::max(1, count) - 1;
+    range.end.col = 0;
+    editor_->applyOperator(op, range, true);
+}
+
+void HotkeyManager::recordChange(int sequenceId, char op, int count, char arg) {
+    if (repeating_) return;
+    lastChange_.sequence = sequenceId;
+    lastChange_.op = op;
+    lastChange_.count = count;
+    lastChange_.arg = arg;
+    lastChange_.text.clear();
+}
+
+void HotkeyManager::finishInsert(const std::string& text) {
+    // Text typed after the last change belongs to it (c, i, o, ...)
+    if (!repeating_) {
+        lastChange_.text = text;
+    }
+}
+
+void HotkeyManager::repeatChange(int count) {
+    if (lastChange_.sequence == KeyTrie::NONE && !lastChange_.op) {
+        return;
+    }
+    
+    // A new count replaces the recorded one, as in 3. after dw
+    if (count > 0) {
+        lastChange_.count = count;
+    }
+    
+    // Re-run the recorded binding directly rather than its keys, then put
+    // back the typed text as one edit
+    repeating_ = true;
+    resetPending();
+    if (lastChange_.sequence == KeyTrie::NONE) {
+        applyToLines(lastChange_.op, lastChange_.count);
+    } else {
+        pendingOperator_ = lastChange_.op;
+        pendingCount_ = lastChange_.count;
+        run(lastChange_.sequence, lastChange_.arg);
+    }
+    if (editor_->getMode() == Mode::INSERT) {
+        editor_->insertAtCursor(lastChange_.text);
+        editor_->setMode(Mode::NORMAL);
+    }
+    repeating_ = false;
+}
+
+void HotkeyManager::applyMotion(const Buffer& buffer, const MotionTarget& target) {
+    Cursor& cursor = editor_->getCursor();
+    
+    if (!pendingOperator_) {
+        if (target.keepColumn) {
+            int delta = target.position.row - cursor.getRow();
+            if (delta > 0) {
+                cursor.moveDown(delta);
+            } else if (delta < 0) {
+                cursor.moveUp(-delta);
+            }
+        } else {
+            cursor.setPosition(target.position.row, target.position.col);
+        }
+        return;
+    }
+    
+    Range range;
+    range.start = cursor.getPosition();
+    range.start.row = std::max(0, std::min(range.start.row, static_cast<int>(buffer.getLines().size()) - 1));
+    range.start.col = std::min(range.start.col, BufferUtils::getLineLength(buffer, range.start.row));
+    range.end = target.position;
+    if (range.end.row < range.start.row ||
+        (range.end.row == range.start.row && range.end.col < range.start.col)) {
+        std::swap(range.start, range.end);
+    }
+    
+    if (!target.linewise) {
+        if (target.inclusive) {
+            // Past the whole last character, however many bytes it takes
+            range.end.col = std::max(range.end.col + 1,
+                                     BufferUtils::nextCharStart(buffer, range.end.row, range.end.col));
+        } else if (range.end.row > range.start.row && range.end.col == 0) {
+            // An exclusive motion onto the start of a later line stops at the
+            // end of the line before it, so dw on the last word keeps the break
+            range.end.row--;
+            range.end.col = BufferUtils::getLineLength(buffer, range.end.row);
+        }
+    }
+    
+    char op = pendingOperator_;
+    resetPending();
+    editor_->applyOperator(op, range, target.linewise);
 }
 
 bool HotkeyManager::handleKey(Mode mode, const KeyInput& input) {
+    PROFILE_SCOPE("HotkeyManager::handleKey");
     if (!editor_) return false;
     
+    // Normal mode characters go through the sequence state machine first
+    if (mode == Mode::NORMAL) {
+        if (input.key == Key::NORMAL) {
+            if (handleSequence(input.character)) {
+                return true;
+            }
+        } else if (input.key != Key::UNKNOWN && isPending()) {
+            // Escape or any special key abandons a half-typed command
+            resetPending();
+            if (input.key == Key::ESCAPE) {
+                return true;
+            }
+        }
+    }
+    
+    if (tablesDirty_) {
+        compileTables();
+    }
+    
     int modeInt = static_cast<int>(mode);
+    if (modeInt < 0 || modeInt >= MODE_COUNT) return false;
     
     // First check key bindings
-    auto modeKeyBindings = keyBindings_.find(modeInt);
-    if (modeKeyBindings != keyBindings_.end()) {
-        auto binding = modeKeyBindings->second.find(input.key);
-        if (binding != modeKeyBindings->second.end()) {
-            binding->second();
-            return true;
+    Action action = keyTable_[modeInt][input.key];
+    
+    // Then check character bindings if this is a normal character
+    if (!action && input.key == Key::NORMAL) {
+        action = charTable_[modeInt][static_cast<unsigned char>(input.character)];
+    }
+    
+    if (action) {
+        (*action)();
+        return true;
+    }
+    return false;
+}
+
+void HotkeyManager::compileTables() {
+    memset(keyTable_, 0, sizeof(keyTable_));
+    memset(charTable_, 0, sizeof(charTable_));
+    
+    // Map nodes are stable, so the tables can point straight at them
+    for (std::map<int, std::map<Key, std::function<void()> > >::const_iterator mode = keyBindings_.begin();
+         mode != keyBindings_.end(); ++mode) {
+        for (std::map<Key, std::function<void()> >::const_iterator it = mode->second.begin();
+             it != mode->second.end(); ++it) {
+            keyTable_[mode->first][it->first] = &it->second;
         }
     }
     
-    // Then check character bindings if this is a normal character
-    if (input.key == Key::NORMAL) {
-        auto modeCharBindings = charBindings_.find(modeInt);
-        if (modeCharBindings != charBindings_.end()) {
-            auto binding = modeCharBindings->second.find(input.character);
-            if (binding != modeCharBindings->second.end()) {
-                binding->second();
-                return true;
-            }
+    for (std::map<int, std::map<char, std::function<void()> > >::const_iterator mode = charBindings_.begin();
+         mode != charBindings_.end(); ++mode) {
+        for (std::map<char, std::function<void()> >::const_iterator it = mode->second.begin();
+             it != mode->second.end(); ++it) {
+            charTable_[mode->first][static_cast<unsigned char>(it->first)] = &it->second;
         }
     }
     
-    return false;
+    tablesDirty_ = false;
 }
 
 void HotkeyManager::setupDefaultBindings() {
     if (!editor_) return;
     
-    // Normal mode movement bindings
-    addNormalModeBinding('h', [this]() {
-        editor_->getCursor().moveLeft(1);
+    // Normal mode motions; with a count, and as targets for d, c and y
+    addMotion("h", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        for (int i = 0; i < std::max(1, count) && target.position.col > 0; ++i) {
+            target.position.col = BufferUtils::prevCharStart(buffer, target.position.row, target.position.col);
+        }
+        return true;
     });
     
-    addNormalModeBinding('j', [this]() {
-        editor_->getCursor().moveDown(1);
+    addMotion("l", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        int length = BufferUtils::getLineLength(buffer, target.position.row);
+        for (int i = 0; i < std::max(1, count) && target.position.col < length; ++i) {
+            target.position.col = BufferUtils::nextCharStart(buffer, target.position.row, target.position.col);
+        }
+        return true;
     });
     
-    addNormalModeBinding('k', [this]() {
-        editor_->getCursor().moveUp(1);
+    addMotion("j", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        int lastRow = static_cast<int>(buffer.getLines().size()) - 1;
+        target.position.row = std::min(lastRow, target.position.row + std::max(1, count));
+        target.linewise = true;
+        target.keepColumn = true;
+        return true;
     });
     
-    addNormalModeBinding('l', [this]() {
-        editor_->getCursor().moveRight(1);
+    addMotion("k", [this](const Buffer&, int count, char, MotionTarget& target) {
+        target.position.row = std::max(0, target.position.row - std::max(1, count));
+        target.linewise = true;
+        target.keepColumn = true;
+        return true;
     });
     
-    addNormalModeBinding('0', [this]() {
-        editor_->getCursor().moveToLineStart();
+    // By screen rows, which differ from lines only when wrapping
+    addMotion("gj", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        target.position = editor_->getViewport().moveByRows(buffer, target.position, std::max(1, count));
+        return true;
     });
     
-    addNormalModeBinding('$', [this]() {
-        editor_->getCursor().moveToLineEnd();
+    addMotion("gk", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        target.position = editor_->getViewport().moveByRows(buffer, target.position, -std::max(1, count));
+        return true;
+    });
+    
+    addMotion("0", [this](const Buffer&, int, char, MotionTarget& target) {
+        target.position.col = 0;
+        return true;
+    });
+    
+    addMotion("^", [this](const Buffer& buffer, int, char, MotionTarget& target) {
+        target.position.col = Motions::firstNonBlank(buffer, target.position.row);
+        return true;
+    });
+    
+    addMotion("$", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        int lastRow = static_cast<int>(buffer.getLines().size()) - 1;
+        target.position.row = std::min(lastRow, target.position.row + std::max(1, count) - 1);
+        target.position.col = BufferUtils::prevCharStart(buffer, target.position.row,
+                                                         BufferUtils::getLineLength(buffer, target.position.row));
+        target.inclusive = true;
+        return true;
+    });
+    
+    addMotion("w", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        const std::string& line = buffer.getLines()[target.position.row];
+        int col = target.position.col;
+        if (pendingOperator_ == 'c' && col < static_cast<int>(line.size()) && line[col] != ' ' && line[col] != '\t') {
+            // cw changes to the end of the word, like ce
+            Position before = target.position;
+            before.col--;
+            target.position = Motions::wordEnd(buffer, before, std::max(1, count));
+            target.inclusive = true;
+            return true;
+        }
+        target.position = Motions::nextWordStart(buffer, target.position, std::max(1, count));
+        return true;
+    });
+    
+    addMotion("b", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        target.position = Motions::prevWordStart(buffer, target.position, std::max(1, count));
+        return true;
+    });
+    
+    addMotion("e", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        target.position = Motions::wordEnd(buffer, target.position, std::max(1, count));
+        target.inclusive = true;
+        return true;
     });
     
-    addNormalModeBinding('w', [this]() {
-        editor_->moveToNextWord();
+    addMotion("gg", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        int lastRow = static_cast<int>(buffer.getLines().size()) - 1;
+        target.position.row = std::min(lastRow, std::max(0, count - 1));
+        target.position.col = Motions::firstNonBlank(buffer, target.position.row);
+        target.linewise = true;
+        return true;
     });
     
-    addNormalModeBinding('b', [this]() {
-        editor_->moveToPrevWord();
+    addMotion("G", [this](const Buffer& buffer, int count, char, MotionTarget& target) {
+        int lastRow = static_cast<int>(buffer.getLines().size()) - 1;
+        target.position.row = count > 0 ? std::min(lastRow, count - 1) : lastRow;
+        target.position.col = Motions::firstNonBlank(buffer, target.position.row);
+        target.linewise = true;
+        return true;
     });
     
-    addNormalModeBinding('e', [this]() {
-        editor_->moveToWordEnd();
+    // f, t, F, T read the character to look for as their argument
+    const char* findKeys = "ftFT";
+    for (int i = 0; i < 4; ++i) {
+        bool forward = i < 2;
+        bool till = i % 2 == 1;
+        addMotion(std::string(1, findKeys[i]), [this, forward, till](const Buffer& buffer, int count, char c, MotionTarget& target) {
+            target.inclusive = forward;
+            return Motions::findChar(buffer, target.position, c,
+                                     std::max(1, count), forward, till, target.position);
+        }, true);
+    }
+    
+    // Operators wait for a motion or text object (or a repeat: dd, cc, yy)
+    addOperator('d');
+    addOperator('c');
+    addOperator('y');
+    
+    addTextObject("iw", [this](const Buffer& buffer, int, Range& range, bool&) {
+        return Motions::word(buffer, editor_->getCursor().getPosition(), false, range);
+    });
+    
+    addTextObject("aw", [this](const Buffer& buffer, int, Range& range, bool&) {
+        return Motions::word(buffer, editor_->getCursor().getPosition(), true, range);
+    });
+    
+    // Counted commands run once over the whole span
+    addChangeCommand("x", [this](int count, char) {
+        Range range;
+        range.start = editor_->getCursor().getPosition();
+        range.end = range.start;
+        auto buffer = editor_->getCurrentBuffer();
+        for (int i = 0; buffer && i < std::max(1, count); ++i) {
+            range.end.col = BufferUtils::nextCharStart(*buffer, range.end.row, range.end.col);
+        }
+        editor_->applyOperator('d', range, false);
+    });
+    
+    addChangeCommand("X", [this](int count, char) {
+        Range range;
+        range.end = editor_->getCursor().getPosition();
+        range.start = range.end;
+        auto buffer = editor_->getCurrentBuffer();
+        for (int i = 0; buffer && i < std::max(1, count) && range.start.col > 0; ++i) {
+            range.start.col = BufferUtils::prevCharStart(*buffer, range.start.row, range.start.col);
+        }
+        editor_->applyOperator('d', range, false);
+    });
+    
+    const char* toEndKeys = "DC";
+    for (int i = 0; i < 2; ++i) {
+        char op = i == 0 ? 'd' : 'c';
+        addChangeCommand(std::string(1, toEndKeys[i]), [this, op](int count, char) {
+            auto buffer = editor_->getCurrentBuffer();
+            if (!buffer) return;
+            Range range;
+            range.start = editor_->getCursor().getPosition();
+            range.end.row = std::min(static_cast<int>(buffer->getLines().size()) - 1,
+                                     range.start.row + std::max(1, count) - 1);
+            range.end.col = BufferUtils::getLineLength(*buffer, range.end.row);
+            editor_->applyOperator(op, range, false);
+        });
+    }
+    
+    // Sideways scrolling without wrap: zl / zh by count columns, zL / zH
+    // by half a screen
+    addNormalModeSequence("zl", [this](int count, char) {
+        editor_->scrollColumns(std::max(1, count));
+    });
+    
+    addNormalModeSequence("zh", [this](int count, char) {
+        editor_->scrollColumns(-std::max(1, count));
+    });
+    
+    addNormalModeSequence("zL", [this](int, char) {
+        editor_->scrollColumns(std::max(1, editor_->getViewport().getTextWidth() / 2));
+    });
+    
+    addNormalModeSequence("zH", [this](int, char) {
+        editor_->scrollColumns(-std::max(1, editor_->getViewport().getTextWidth() / 2));
+    });
+    
+    addNormalModeSequence("Y", [this](int count, char) {
+        Range range;
+        range.start = editor_->getCursor().getPosition();
+        range.end = range.start;
+        range.end.row += std::max(1, count) - 1;
+        editor_->applyOperator('y', range, true);
+    });
+    
+    addChangeCommand("p", [this](int count, char) {
+        editor_->put(true, std::max(1, count));
     });
     
-    // Normal mode mode switching
-    addNormalModeBinding('i', [this]() {
+    addChangeCommand("P", [this](int count, char) {
+        editor_->put(false, std::max(1, count));
+    });
+    
+    addChangeCommand("J", [this](int count, char) {
+        editor_->joinLines(count);
+    });
+    
+    // Macros; q while recording is handled by the editor, so the stop key is
+    // never part of the recording
+    addNormalModeSequence("q", [this](int, char reg) {
+        editor_->startRecording(reg);
+    }, true);
+    
+    addNormalModeSequence("@", [this](int count, char reg) {
+        editor_->replayMacro(reg, std::max(1, count));
+    }, true);
+    
+    addNormalModeSequence(".", [this](int count, char) {
+        repeatChange(count);
+    });
+    
+    // Normal mode mode switching; entering insert mode is a change, so "."
+    // repeats it along with the text typed
+    addChangeCommand("i", [this](int, char) {
         editor_->setMode(Mode::INSERT);
     });
     
-    addNormalModeBinding('a', [this]() {
-        editor_->getCursor().moveRight(1);
+    addChangeCommand("a", [this](int, char) {
+        auto& cursor = editor_->getCursor();
+        auto buffer = editor_->getCurrentBuffer();
+        if (buffer) {
+            cursor.setCol(BufferUtils::nextCharStart(*buffer, cursor.getRow(), cursor.getCol()));
+        }
+        cursor.limitToValidPosition(buffer);
         editor_->setMode(Mode::INSERT);
     });
     
-    addNormalModeBinding('A', [this]() {
+    addChangeCommand("A", [this](int, char) {
+        // Clamp now, or the first typed character lands past the line end
         editor_->getCursor().moveToLineEnd();
+        editor_->getCursor().limitToValidPosition(editor_->getCurrentBuffer());
         editor_->setMode(Mode::INSERT);
     });
     
-    addNormalModeBinding('I', [this]() {
+    addChangeCommand("I", [this](int, char) {
         editor_->getCursor().moveToLineStart();
         editor_->setMode(Mode::INSERT);
     });
     
-    addNormalModeBinding('o', [this]() {
+    addChangeCommand("o", [this](int, char) {
         editor_->insertLineBelow();
         editor_->setMode(Mode::INSERT);
     });
     
-    addNormalModeBinding('O', [this]() {
+    addChangeCommand("O", [this](int, char) {
         editor_->insertLineAbove();
         editor_->setMode(Mode::INSERT);
     });
     
+    // Names for user key bindings in the config file
+    static const char* const ACTION_KEYS[][2] = {
+        { "moveLeft", "h" }, { "moveRight", "l" }, { "moveDown", "j" }, { "moveUp", "k" },
+        { "moveDisplayDown", "gj" }, { "moveDisplayUp", "gk" },
+        { "scrollRight", "zl" }, { "scrollLeft", "zh" },
+        { "gotoLineStart", "0" }, { "gotoFirstNonBlank", "^" }, { "gotoLineEnd", "$" },
+        { "nextWord", "w" }, { "prevWord", "b" }, { "wordEnd", "e" },
+        { "gotoFirstLine", "gg" }, { "gotoLastLine", "G" },
+        { "findChar", "f" }, { "tillChar", "t" }, { "findCharBackward", "F" }, { "tillCharBackward", "T" },
+        { "delete", "d" }, { "change", "c" }, { "yank", "y" },
+        { "innerWord", "iw" }, { "aroundWord", "aw" },
+        { "deleteChar", "x" }, { "deleteCharBefore", "X" },
+        { "deleteToLineEnd", "D" }, { "changeToLineEnd", "C" }, { "yankLine", "Y" },
+        { "putAfter", "p" }, { "putBefore", "P" }, { "joinLines", "J" },
+        { "recordMacro", "q" }, { "playMacro", "@" }, { "repeatChange", "." },
+        { "insert", "i" }, { "append", "a" }, { "appendAtLineEnd", "A" },
+        { "insertAtLineStart", "I" }, { "openLineBelow", "o" }, { "openLineAbove", "O" }
+    };
+    for (size_t i = 0; i < sizeof(ACTION_KEYS) / sizeof(ACTION_KEYS[0]); ++i) {
+        addAction(ACTION_KEYS[i][0], ACTION_KEYS[i][1]);
+    }
+    
+    addAction("visualMode", [this](int, char) {
+        editor_->setMode(Mode::VISUAL);
+    });
+    
+    addAction("visualLineMode", [this](int, char) {
+        editor_->setMode(Mode::VISUAL_LINE);
+    });
+    
+    addAction("commandMode", [this](int, char) {
+        editor_->setMode(Mode::COMMAND);
+    });
+    
+    addAction("showHelp", [this](int, char) {
+        editor_->showHelp();
+    });
+    
     addNormalModeBinding('v', [this]() {
         editor_->setMode(Mode::VISUAL);
     });
@@ -182,8 +898,12 @@ void HotkeyManager::setupDefaultBindings() {
         auto buffer = editor_->getCurrentBuffer();
         if (buffer) {
             if (cursor.getCol() > 0) {
-                BufferUtils::deleteCharAtPosition(*buffer, cursor.getRow(), cursor.getCol() - 1);
-                cursor.moveLeft(1);
+                Range range;
+                range.end = cursor.getPosition();
+                range.start = range.end;
+                range.start.col = BufferUtils::prevCharStart(*buffer, range.end.row, range.end.col);
+                BufferUtils::deleteText(*buffer, range);
+                cursor.setCol(range.start.col);
             } else if (cursor.getRow() > 0) {
                 int prevLineLength = BufferUtils::getLineLength(*buffer, cursor.getRow() - 1);
                 BufferUtils::joinLines(*buffer, cursor.getRow() - 1);
@@ -207,6 +927,7 @@ void HotkeyManager::setupDefaultBindings() {
     
     addCommandModeBinding(Key::ENTER, [this]() {
         editor_->executeCommand();
+        editor_->clearCommandBuffer();
         editor_->setMode(Mode::NORMAL);
     });
     
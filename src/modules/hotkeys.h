@@ -3,13 +3,42 @@
 
 #include <map>
 #include <string>
+#include <vector>
+#include <chrono>
 #include <functional>
 #include "terminal.h"
 #include "editor.h"
+#include "keytrie.h"
 
 namespace cvim {
 
 class Editor;
+struct KeyBinding;
+
+// Where a motion lands, and how an operator treats the span up to it
+struct MotionTarget {
+    Position position;
+    bool linewise;     // j, k, gg, G: whole lines
+    bool inclusive;    // e, $, f: the target character is part of the span
+    bool keepColumn;   // vertical motion; the cursor keeps its remembered column
+};
+
+// Counts are 0 when none was typed. arg is the character read after
+// motions like f/t, otherwise 0. Motions start with target.position at the
+// cursor, clamped into the buffer.
+typedef std::function<bool(const Buffer& buffer, int count, char arg, MotionTarget& target)> MotionFn;
+typedef std::function<bool(const Buffer& buffer, int count, Range& range, bool& linewise)> TextObjectFn;
+typedef std::function<void(int count, char arg)> CommandFn;
+
+// The last change, kept for "." to re-apply: the binding that made it with
+// its operator, count and argument, plus any text typed afterwards
+struct Change {
+    int sequence;      // KeyTrie::NONE for dd, cc
+    char op;
+    int count;
+    char arg;
+    std::string text;
+};
 
 class HotkeyManager {
 public:
@@ -35,16 +64,119 @@ public:
     void addCommandModeBinding(Key key, std::function<void()> action);
     void addCommandModeBinding(char key, std::function<void()> action);
     
+    // Normal mode key sequences ("gg", "dd", "d2w", "ciw", "3j"). Motions
+    // also work after an operator; text objects only there.
+    void addMotion(const std::string& keys, MotionFn motion, bool takesChar = false);
+    void addOperator(char key);
+    void addTextObject(const std::string& keys, TextObjectFn textObject);
+    void addNormalModeSequence(const std::string& keys, CommandFn command, bool takesChar = false);
+    // A command that changes text, so "." repeats it
+    void addChangeCommand(const std::string& keys, CommandFn command, bool takesChar = false);
+    
     // Handle a key input in the given mode
     bool handleKey(Mode mode, const KeyInput& input);
     
+    // Run the binding of an ambiguous prefix once the timeout has passed;
+    // true if the pending state changed
+    bool checkTimeout();
+    void setTimeout(int milliseconds);
+    // True while checkTimeout() has something to settle: a partial
+    // sequence. Counts, operators and f/t wait for the next key forever.
+    bool isWaitingForTimeout() const;
+    
+    // Pending count, operator or partial sequence
+    bool isPending() const;
+    const std::string& getPendingKeys() const;
+    void resetPending();
+    
+    // "." support: the editor hands over the text typed in insert mode when
+    // it leaves it, and repeatChange re-applies the last change
+    void finishInsert(const std::string& text);
+    void repeatChange(int count);
+    
     // Setup default bindings
     void setupDefaultBindings();
     
+    // Named actions for user key bindings. The first form names the
+    // sequence already bound to keys; the second adds an unbound command.
+    void addAction(const std::string& name, const std::string& keys);
+    void addAction(const std::string& name, CommandFn command, bool change = false);
+    
+    // Replace the user bindings (from the config's keybindings) on top of
+    // the defaults. Only normal mode is supported. Returns false with a
+    // message for the first binding that could not be applied; the others
+    // still take effect.
+    bool applyKeyBindings(const std::vector<KeyBinding>& bindings, std::string& error);
+    
 private:
+    static const int MODE_COUNT = static_cast<int>(Mode::COMMAND) + 1;
+    static const int KEY_COUNT = static_cast<int>(Key::UNKNOWN) + 1;
+    static const int CHAR_COUNT = 256;
+    
+    typedef const std::function<void()>* Action;
+    
+    enum SequenceKind {
+        SEQ_MOTION,
+        SEQ_OPERATOR,
+        SEQ_TEXT_OBJECT,
+        SEQ_COMMAND
+    };
+    
+    struct Sequence {
+        std::string keys;  // default keys, empty for unbound actions
+        bool operatorPending;
+        SequenceKind kind;
+        char op;
+        bool takesChar;
+        bool change;
+        MotionFn motion;
+        TextObjectFn textObject;
+        CommandFn command;
+    };
+    
+    // Rebuild the flat tables from the binding maps
+    void compileTables();
+    
+    // Feed one normal mode character through the sequence state machine;
+    // false if no sequence starts with it
+    bool handleSequence(char c);
+    void dispatch(int sequenceId);
+    void run(int sequenceId, char arg);
+    void applyMotion(const Buffer& buffer, const MotionTarget& target);
+    void applyToLines(char op, int count);
+    void recordChange(int sequenceId, char op, int count, char arg);
+    int takeCount();
+    int addSequence(const std::string& keys, const Sequence& sequence, bool operatorPending);
+    void bindSequence(const std::string& keys, int sequenceId);
+    int findSequence(const std::string& keys) const;
+    const KeyTrie& activeTrie() const;
+    
     Editor* editor_;
     std::map<int, std::map<Key, std::function<void()> > > keyBindings_;
     std::map<int, std::map<char, std::function<void()> > > charBindings_;
+    
+    // Dense per-mode dispatch tables pointing into the maps above, so a
+    // keystroke costs one indexed load. Recompiled after bindings change.
+    Action keyTable_[MODE_COUNT][KEY_COUNT];
+    Action charTable_[MODE_COUNT][CHAR_COUNT];
+    bool tablesDirty_;
+    
+    std::vector<Sequence> sequences_;
+    std::map<std::string, int> actions_;
+    KeyTrie normalTrie_;
+    KeyTrie operatorTrie_;
+    
+    int pendingCount_;
+    char pendingOperator_;
+    int operatorCount_;
+    int node_;
+    int awaitingChar_;
+    std::string pendingKeys_;
+    std::chrono::steady_clock::time_point pendingSince_;
+    int timeoutMs_;
+    
+    Change lastChange_;
+    bool repeating_;
 };
 
 } // namespace cvim
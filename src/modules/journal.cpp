@@ -0,0 +1,398 @@
+#include "journal.h"
+#include "buffer_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cvim {
+
+static const char* SWAP_MAGIC = "CVIMSWP1";
+
+static void putVarint(std::string& out, unsigned long value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static bool getVarint(const std::string& in, size_t& pos, unsigned long& value) {
+    value = 0;
+    int shift = 0;
+    while (pos < in.size() && shift < 64) {
+        unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<unsigned long>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+        shift += 7;
+    }
+    return false;
+}
+
+static bool pwriteAll(int fd, const char* data, size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+static std::string describeFile(const std::string& filePath) {
+    struct stat st;
+    std::stringstream ss;
+    if (stat(filePath.c_str(), &st) == 0) {
+        ss << st.st_size << " " << st.st_mtime;
+    } else {
+        ss << "0 0";
+    }
+    return ss.str();
+}
+
+// Apply one record with the same semantics the editor used to produce it
+static bool applyRecord(Buffer& buffer, EditOp op, int row, int col, const std::string& text) {
+    int lineCount = static_cast<int>(buffer.getLines().size());
+    switch (op) {
+        case EDIT_INSERT_CHAR:
+            if (text.empty()) return false;
+            BufferUtils::insertCharAtPosition(buffer, row, col, text[0]);
+            return true;
+        case EDIT_DELETE_CHAR:
+            BufferUtils::deleteCharAtPosition(buffer, row, col);
+            return true;
+        case EDIT_LINE_BREAK:
+            BufferUtils::insertLineBreak(buffer, row, col);
+            return true;
+        case EDIT_JOIN_LINES:
+            BufferUtils::joinLines(buffer, row);
+            return true;
+        case EDIT_INSERT_LINE:
+            if (row < 0 || row > lineCount) return false;
+            buffer.getMutableLines().insert(buffer.getMutableLines().begin() + row, text);
+            buffer.setModified(true);
+            return true;
+        case EDIT_DELETE_LINE:
+            buffer.deleteLine(row);
+            return true;
+        case EDIT_DELETE_LINES:
+            if (row < 0 || row >= lineCount) return false;
+            BufferUtils::deleteLines(buffer, row, col);
+            return true;
+        case EDIT_INSERT_TEXT:
+            BufferUtils::insertText(buffer, row, col, text);
+            return true;
+        case EDIT_DELETE_TEXT: {
+            // The deleted text gives the extent of the range
+            Range range;
+            range.start.row = row;
+            range.start.col = col;
+            size_t lastNewline = text.rfind('\n');
+            range.end.row = row + static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+            range.end.col = lastNewline == std::string::npos ? col + static_cast<int>(text.size())
+                                                             : static_cast<int>(text.size() - lastNewline - 1);
+            BufferUtils::deleteText(buffer, range);
+            return true;
+        }
+        case EDIT_INSERT_LINES: {
+            if (row < 0 || row > lineCount) return false;
+            BufferUtils::insertLines(buffer, row, BufferUtils::splitLines(text));
+            return true;
+        }
+        case EDIT_REPLACE_LINES:
+            if (row < 0 || row >= lineCount) return false;
+            BufferUtils::replaceLines(buffer, row, col, BufferUtils::splitLines(text));
+            return true;
+    }
+    return false;
+}
+
+Journal::Journal(const std::string& filePath)
+    : filePath_(filePath), swapPath_(swapPathFor(filePath)), fd_(-1),
+      headerSize_(0), appended_(0), flushed_(0), errorReported_(false) {}
+
+Journal::~Journal() {
+    // The swap may hold the only copy of unsaved edits, so it stays on
+    // disk; owners discard() it once the buffer is clean
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    if (fd_ < 0) return;
+    flushLocked(true);
+    close(fd_);
+}
+
+std::string Journal::swapPathFor(const std::string& filePath) {
+    std::string dir = getDirectoryPath(filePath);
+    std::string prefix = dir.empty() ? "" : dir + "/";
+    return prefix + "." + getFileName(filePath) + ".cvimswp";
+}
+
+bool Journal::hasLeftover(const std::string& filePath) {
+    std::ifstream swap(swapPathFor(filePath), std::ios::binary);
+    if (!swap.is_open()) return false;
+
+    // Header is two lines; anything after them is a record
+    std::string line;
+    if (!std::getline(swap, line) || line.compare(0, strlen(SWAP_MAGIC), SWAP_MAGIC) != 0) return false;
+    if (!std::getline(swap, line)) return false;
+    return swap.peek() != std::char_traits<char>::eof();
+}
+
+Result Journal::replay(const std::string& filePath, Buffer& buffer, int& recovered) {
+    std::ifstream swap(swapPathFor(filePath), std::ios::binary);
+    if (!swap.is_open()) {
+        return Result::error("No swap file for " + filePath);
+    }
+
+    std::string header;
+    std::string path;
+    size_t magicSize = strlen(SWAP_MAGIC);
+    if (!std::getline(swap, header) || !std::getline(swap, path) ||
+        header.compare(0, magicSize, SWAP_MAGIC) != 0 ||
+        header.size() <= magicSize || header[magicSize] != ' ') {
+        return Result::error("Swap file is corrupt");
+    }
+
+    // The records only make sense against the file they were made on
+    if (header.compare(magicSize + 1, std::string::npos, describeFile(filePath)) != 0) {
+        return Result::error(filePath + " changed since the swap file was written");
+    }
+
+    std::string data((std::istreambuf_iterator<char>(swap)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    int applied = 0;
+    while (pos < data.size()) {
+        EditOp op = static_cast<EditOp>(static_cast<unsigned char>(data[pos++]));
+        unsigned long row, col, length;
+        if (!getVarint(data, pos, row) || !getVarint(data, pos, col) ||
+            !getVarint(data, pos, length) || pos + length > data.size()) {
+            // Torn final record from the crash; everything before it is good
+            break;
+        }
+        std::string text = data.substr(pos, length);
+        pos += length;
+
+        if (!applyRecord(buffer, op, static_cast<int>(row), static_cast<int>(col), text)) {
+            break;
+        }
+        ++applied;
+    }
+
+    if (applied == 0) {
+        return Result::error("Nothing to recover");
+    }
+    recovered = applied;
+    return Result::success();
+}
+
+bool Journal::open(bool append) {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) return true;
+
+    fd_ = ::open(swapPath_.c_str(), O_RDWR | O_CREAT | (append ? 0 : O_TRUNC), 0600);
+    if (fd_ < 0) return false;
+
+    if (append) {
+        // Continue after the existing header and records
+        std::ifstream swap(swapPath_, std::ios::binary);
+        std::string magic, path;
+        struct stat st;
+        if (std::getline(swap, magic) && std::getline(swap, path) && fstat(fd_, &st) == 0) {
+            headerSize_ = magic.size() + path.size() + 2;
+            appended_ = flushed_ = static_cast<size_t>(st.st_size) - headerSize_;
+            return true;
+        }
+    }
+
+    std::string header = makeHeader();
+    headerSize_ = header.size();
+    appended_ = flushed_ = 0;
+    return ftruncate(fd_, 0) == 0 && pwriteAll(fd_, header.data(), header.size(), 0);
+}
+
+void Journal::discard() {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) return;
+
+    close(fd_);
+    fd_ = -1;
+    unlink(swapPath_.c_str());
+    pending_.clear();
+}
+
+void Journal::append(EditOp op, int row, int col, const std::string& text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) return;
+
+    size_t before = pending_.size();
+    pending_ += static_cast<char>(op);
+    putVarint(pending_, static_cast<unsigned long>(row));
+    putVarint(pending_, static_cast<unsigned long>(col));
+    putVarint(pending_, text.size());
+    pending_ += text;
+    appended_ += pending_.size() - before;
+}
+
+bool Journal::flush(bool sync) {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    return flushLocked(sync);
+}
+
+std::string Journal::takeError() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_.empty() || errorReported_) return std::string();
+    errorReported_ = true;
+    return error_;
+}
+
+size_t Journal::mark() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appended_;
+}
+
+void Journal::rebase(size_t mark) {
+    std::lock_guard<std::mutex> ioLock(ioMutex_);
+    if (fd_ < 0) return;
+
+    flushLocked(false);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mark > appended_) mark = appended_;
+
+    // Records after the mark were made on top of what is now on disk
+    std::string tail(appended_ - mark, '\0');
+    if (!tail.empty()) {
+        ssize_t got = pread(fd_, &tail[0], tail.size(), static_cast<off_t>(headerSize_ + mark));
+        tail.resize(got > 0 ? static_cast<size_t>(got) : 0);
+    }
+
+    std::string header = makeHeader();
+    if (ftruncate(fd_, 0) == 0 && pwriteAll(fd_, header.data(), header.size(), 0) &&
+        pwriteAll(fd_, tail.data(), tail.size(), static_cast<off_t>(header.size()))) {
+        fdatasync(fd_);
+    }
+    headerSize_ = header.size();
+    appended_ = flushed_ = tail.size();
+}
+
+const std::string& Journal::getSwapPath() const {
+    return swapPath_;
+}
+
+std::string Journal::makeHeader() const {
+    return std::string(SWAP_MAGIC) + " " + describeFile(filePath_) + "\n" + filePath_ + "\n";
+}
+
+bool Journal::flushLocked(bool sync) {
+    if (fd_ < 0) return true;
+
+    // Swap the records out so append() never waits on the disk
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writing_.swap(pending_);
+    }
+
+    int error = 0;
+    if (!writing_.empty()) {
+        if (pwriteAll(fd_, writing_.data(), writing_.size(), static_cast<off_t>(headerSize_ + flushed_))) {
+            flushed_ += writing_.size();
+            writing_.clear();
+        } else {
+            error = errno;
+        }
+    }
+    if (!error && sync && fdatasync(fd_) != 0) {
+        error = errno;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error) {
+        error_.clear();
+        errorReported_ = false;
+        return true;
+    }
+    // Keep the records, ahead of anything appended meanwhile, and retry
+    // them on the next flush rather than lose them
+    error_ = strerror(error);
+    if (!writing_.empty()) {
+        pending_.insert(0, writing_);
+        writing_.clear();
+    }
+    return false;
+}
+
+// JournalWriter implementation
+JournalWriter::JournalWriter(int flushIntervalMs, int syncIntervalMs)
+    : flushIntervalMs_(flushIntervalMs), syncIntervalMs_(syncIntervalMs), stopping_(false) {
+    thread_ = std::thread(&JournalWriter::run, this);
+}
+
+JournalWriter::~JournalWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+void JournalWriter::addJournal(const std::shared_ptr<Journal>& journal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    journals_.push_back(journal);
+}
+
+void JournalWriter::setNotifier(std::function<void()> notify) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notify_ = notify;
+}
+
+void JournalWriter::run() {
+    std::chrono::steady_clock::time_point lastSync = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wakeup_.wait_for(lock, std::chrono::milliseconds(flushIntervalMs_));
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        bool sync = stopping_ ||
+            now - lastSync >= std::chrono::milliseconds(syncIntervalMs_);
+
+        // Drop journals whose buffers are gone, flush the rest in one batch
+        std::vector<std::shared_ptr<Journal> > live;
+        std::vector<std::weak_ptr<Journal> > remaining;
+        for (size_t i = 0; i < journals_.size(); ++i) {
+            std::shared_ptr<Journal> journal = journals_[i].lock();
+            if (journal) {
+                live.push_back(journal);
+                remaining.push_back(journal);
+            }
+        }
+        journals_.swap(remaining);
+
+        bool stopping = stopping_;
+        std::function<void()> notify = notify_;
+        lock.unlock();
+        bool failed = false;
+        for (size_t i = 0; i < live.size(); ++i) {
+            if (!live[i]->flush(sync)) failed = true;
+        }
+        live.clear();
+        if (failed && notify) notify();
+        lock.lock();
+
+        if (sync) lastSync = now;
+        if (stopping) break;
+    }
+}
+
+} // namespace cvim
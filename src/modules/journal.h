@@ -0,0 +1,103 @@
+#ifndef CVIM_JOURNAL_H
+#define CVIM_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include "editor.h"
+
+namespace cvim {
+
+// Append-only edit log (swap file) for crash recovery. Records are buffered
+// in memory on the input path and written out by the JournalWriter thread.
+//
+// File layout: a text header "CVIMSWP1 <size> <mtime>\n<path>\n" describing
+// the file on disk the records apply to, followed by binary records of
+// [op byte][row varint][col varint][text length varint][text bytes].
+class Journal {
+public:
+    explicit Journal(const std::string& filePath);
+    ~Journal();
+
+    // Swap file location for a given file: ".<name>.cvimswp" next to it
+    static std::string swapPathFor(const std::string& filePath);
+    // True if a swap file with at least one record exists for filePath
+    static bool hasLeftover(const std::string& filePath);
+    // Apply the records of filePath's swap file to buffer (loaded from disk)
+    static Result replay(const std::string& filePath, Buffer& buffer, int& recovered);
+
+    // Start a new journal, or continue an existing one after replay()
+    bool open(bool append = false);
+    // Close and delete the swap file. Destroying a journal only closes it.
+    void discard();
+
+    // Called on every edit; only touches memory
+    void append(EditOp op, int row, int col, const std::string& text);
+
+    // Write buffered records out; fsync when requested. On a write error
+    // the records stay queued for the next flush and false is returned.
+    bool flush(bool sync);
+    // The last write error, once per run of failures; empty otherwise
+    std::string takeError();
+
+    // Position in the record stream, taken when a save snapshot is made
+    size_t mark() const;
+    // The snapshot taken at mark is now on disk: keep only later records.
+    // Called on the main thread, so no appends race it.
+    void rebase(size_t mark);
+
+    const std::string& getSwapPath() const;
+
+private:
+    std::string makeHeader() const;
+    // Requires ioMutex_
+    bool flushLocked(bool sync);
+
+    std::string filePath_;
+    std::string swapPath_;
+    int fd_;
+    size_t headerSize_;
+
+    // ioMutex_ serialises file access; mutex_ only guards the in-memory
+    // records, so appends never wait behind a write. Lock order: io first.
+    std::mutex ioMutex_;
+    mutable std::mutex mutex_;
+    std::string pending_;
+    std::string writing_;
+    size_t appended_;  // total record bytes since the header
+    size_t flushed_;   // record bytes already written to fd_
+    std::string error_;   // set while writes are failing
+    bool errorReported_;
+};
+
+// Single background thread that flushes every registered journal in batches
+// and fsyncs them periodically, keeping disk I/O off the keystroke path.
+class JournalWriter {
+public:
+    JournalWriter(int flushIntervalMs = 200, int syncIntervalMs = 1000);
+    ~JournalWriter();
+
+    void addJournal(const std::shared_ptr<Journal>& journal);
+    // Called from the writer thread after a flush fails
+    void setNotifier(std::function<void()> notify);
+
+private:
+    void run();
+
+    int flushIntervalMs_;
+    int syncIntervalMs_;
+    bool stopping_;
+    std::vector<std::weak_ptr<Journal> > journals_;
+    std::function<void()> notify_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_JOURNAL_H
@@ -0,0 +1,120 @@
+#include "keynotation.h"
+#include <cstdlib>
+
+namespace cvim {
+
+namespace {
+
+struct KeyName {
+    Key key;
+    const char* name;
+    char character;  // what Terminal::getInput() reports with the key
+};
+
+const KeyName KEY_NAMES[] = {
+    { Key::ESCAPE,    "Esc",      27 },
+    { Key::ENTER,     "CR",       13 },
+    { Key::BACKSPACE, "BS",       127 },
+    { Key::DELETE,    "Del",      0 },
+    { Key::TAB,       "Tab",      9 },
+    { Key::UP,        "Up",       0 },
+    { Key::DOWN,      "Down",     0 },
+    { Key::LEFT,      "Left",     0 },
+    { Key::RIGHT,     "Right",    0 },
+    { Key::HOME,      "Home",     0 },
+    { Key::END,       "End",      0 },
+    { Key::PAGE_UP,   "PageUp",   0 },
+    { Key::PAGE_DOWN, "PageDown", 0 },
+};
+
+const int KEY_NAME_COUNT = sizeof(KEY_NAMES) / sizeof(KEY_NAMES[0]);
+
+KeyInput makeInput(Key key, char character) {
+    KeyInput input;
+    input.key = key;
+    input.character = character;
+    input.shift = false;
+    input.ctrl = false;
+    input.alt = false;
+    return input;
+}
+
+bool lookupName(const std::string& name, KeyInput& input) {
+    for (int i = 0; i < KEY_NAME_COUNT; ++i) {
+        if (name == KEY_NAMES[i].name) {
+            input = makeInput(KEY_NAMES[i].key, KEY_NAMES[i].character);
+            return true;
+        }
+    }
+    if (name == "lt") {
+        input = makeInput(Key::NORMAL, '<');
+        return true;
+    }
+    if (name.size() == 3 && name.compare(0, 2, "C-") == 0 && name[2] >= 'a' && name[2] <= 'z') {
+        input = makeInput(static_cast<Key>(Key::CTRL_A + (name[2] - 'a')), name[2] - 'a' + 1);
+        input.ctrl = true;
+        return true;
+    }
+    if (name.size() >= 2 && name[0] == 'F') {
+        int number = atoi(name.c_str() + 1);
+        if (number >= 1 && number <= 12 && name == "F" + std::to_string(number)) {
+            input = makeInput(static_cast<Key>(Key::F1 + number - 1), 0);
+            return true;
+        }
+    }
+    if (name.compare(0, 5, "Char-") == 0 && name.size() > 5) {
+        int code = atoi(name.c_str() + 5);
+        if (code >= 0 && code <= 255 && name == "Char-" + std::to_string(code)) {
+            input = makeInput(Key::NORMAL, static_cast<char>(code));
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+std::string formatKey(const KeyInput& input) {
+    if (input.key == Key::NORMAL) {
+        unsigned char c = static_cast<unsigned char>(input.character);
+        if (c == '<') return "<lt>";
+        if (c < 32 || c == 127) return "<Char-" + std::to_string(c) + ">";
+        return std::string(1, input.character);
+    }
+    for (int i = 0; i < KEY_NAME_COUNT; ++i) {
+        if (input.key == KEY_NAMES[i].key) {
+            return std::string("<") + KEY_NAMES[i].name + ">";
+        }
+    }
+    if (input.key >= Key::CTRL_A && input.key <= Key::CTRL_Z) {
+        return std::string("<C-") + static_cast<char>('a' + (input.key - Key::CTRL_A)) + ">";
+    }
+    if (input.key >= Key::F1 && input.key <= Key::F12) {
+        return "<F" + std::to_string(input.key - Key::F1 + 1) + ">";
+    }
+    return "";
+}
+
+bool parseKeys(const std::string& text, std::vector<KeyInput>& keys, std::string& error) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '\n' || c == '\r') continue;
+        
+        if (c == '<') {
+            size_t end = text.find('>', i + 1);
+            KeyInput input;
+            if (end == std::string::npos || !lookupName(text.substr(i + 1, end - i - 1), input)) {
+                error = "Unknown key at offset " + std::to_string(i) + ": " +
+                        text.substr(i, end == std::string::npos ? 16 : end - i + 1);
+                return false;
+            }
+            keys.push_back(input);
+            i = end;
+        } else {
+            keys.push_back(makeInput(Key::NORMAL, c));
+        }
+    }
+    return true;
+}
+
+} // namespace cvim
@@ -0,0 +1,23 @@
+#ifndef CVIM_KEYNOTATION_H
+#define CVIM_KEYNOTATION_H
+
+#include <string>
+#include <vector>
+#include "terminal.h"
+
+namespace cvim {
+
+// Keys in vim's <> notation, for recorded key scripts (cvim --record):
+// printable characters stand for themselves, special keys are written
+// <Esc>, <CR>, <BS>, <Del>, <Tab>, <Up>, <PageDown>, <C-a>, <F1>, ...,
+// a literal '<' is <lt> and other control characters are <Char-N>.
+// Parsing what formatKey() wrote gives back the same KeyInput.
+std::string formatKey(const KeyInput& input);
+
+// Newlines in text are layout only and ignored. false with a message on
+// an unknown <name>.
+bool parseKeys(const std::string& text, std::vector<KeyInput>& keys, std::string& error);
+
+} // namespace cvim
+
+#endif // CVIM_KEYNOTATION_H
@@ -0,0 +1,64 @@
+#include "keytrie.h"
+
+namespace cvim {
+
+KeyTrie::KeyTrie() {
+    clear();
+}
+
+void KeyTrie::insert(const std::string& keys, int actionId) {
+    if (keys.empty()) return;
+
+    int node = ROOT;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        int next = step(node, keys[i]);
+        if (next == NONE) {
+            Node child;
+            child.action = NONE;
+            nodes_.push_back(child);
+            next = static_cast<int>(nodes_.size()) - 1;
+
+            if (node == ROOT) {
+                rootChildren_[static_cast<unsigned char>(keys[i])] = next;
+            }
+            nodes_[node].children.push_back(std::make_pair(keys[i], next));
+        }
+        node = next;
+    }
+    nodes_[node].action = actionId;
+}
+
+void KeyTrie::clear() {
+    nodes_.clear();
+    Node root;
+    root.action = NONE;
+    nodes_.push_back(root);
+    for (int i = 0; i < 256; ++i) {
+        rootChildren_[i] = NONE;
+    }
+}
+
+int KeyTrie::step(int node, char c) const {
+    if (node == ROOT) {
+        return rootChildren_[static_cast<unsigned char>(c)];
+    }
+
+    // Inner nodes have a handful of children at most
+    const std::vector<std::pair<char, int> >& children = nodes_[node].children;
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i].first == c) {
+            return children[i].second;
+        }
+    }
+    return NONE;
+}
+
+int KeyTrie::actionAt(int node) const {
+    return nodes_[node].action;
+}
+
+bool KeyTrie::hasChildren(int node) const {
+    return !nodes_[node].children.empty();
+}
+
+} // namespace cvim
@@ -0,0 +1,43 @@
+#ifndef CVIM_KEYTRIE_H
+#define CVIM_KEYTRIE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace cvim {
+
+// Prefix tree over key sequences ("dd", "gg", "iw", ...). Nodes are indices
+// into a flat vector; the root has a dense table since every sequence
+// starts there.
+class KeyTrie {
+public:
+    static const int ROOT = 0;
+    static const int NONE = -1;
+
+    KeyTrie();
+
+    // Bind keys to an action id, replacing an existing binding
+    void insert(const std::string& keys, int actionId);
+    void clear();
+
+    // Child of node for key c, or NONE
+    int step(int node, char c) const;
+    // Action bound at node, or NONE
+    int actionAt(int node) const;
+    // True if longer sequences continue from node
+    bool hasChildren(int node) const;
+
+private:
+    struct Node {
+        int action;
+        std::vector<std::pair<char, int> > children;
+    };
+
+    std::vector<Node> nodes_;
+    int rootChildren_[256];
+};
+
+} // namespace cvim
+
+#endif // CVIM_KEYTRIE_H
@@ -0,0 +1,216 @@
+#include "motions.h"
+#include "buffer_utils.h"
+
+namespace cvim {
+
+// Character classes for word motions: blanks, punctuation, word characters
+enum {
+    CLASS_BLANK = 0,
+    CLASS_PUNCT = 1,
+    CLASS_WORD = 2
+};
+
+int Motions::charClass(char c) {
+    if (c == ' ' || c == '\t') return CLASS_BLANK;
+    return BufferUtils::isWordChar(c) ? CLASS_WORD : CLASS_PUNCT;
+}
+
+Position Motions::nextWordStart(const Buffer& buffer, Position pos, int count) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    int lastRow = static_cast<int>(lines.size()) - 1;
+    if (pos.row < 0 || pos.row > lastRow) return pos;
+
+    for (int i = 0; i < count; ++i) {
+        const std::string* line = &lines[pos.row];
+        int length = static_cast<int>(line->size());
+
+        // Skip the rest of the current word
+        if (pos.col < length) {
+            int cls = charClass((*line)[pos.col]);
+            if (cls != CLASS_BLANK) {
+                while (pos.col < length && charClass((*line)[pos.col]) == cls) {
+                    pos.col++;
+                }
+            }
+        }
+
+        // Then blanks, continuing onto following lines; an empty line is a word
+        while (true) {
+            while (pos.col < length && charClass((*line)[pos.col]) == CLASS_BLANK) {
+                pos.col++;
+            }
+            if (pos.col < length) break;
+            if (pos.row >= lastRow) {
+                return pos;
+            }
+            pos.row++;
+            pos.col = 0;
+            line = &lines[pos.row];
+            length = static_cast<int>(line->size());
+            if (length == 0) break;
+        }
+    }
+    return pos;
+}
+
+Position Motions::prevWordStart(const Buffer& buffer, Position pos, int count) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    if (pos.row < 0 || pos.row >= static_cast<int>(lines.size())) return pos;
+
+    for (int i = 0; i < count; ++i) {
+        // Step back one character, possibly onto the previous line
+        bool crossed = false;
+        if (pos.col > 0) {
+            pos.col = std::min(pos.col, static_cast<int>(lines[pos.row].size())) - 1;
+        } else if (pos.row > 0) {
+            pos.row--;
+            pos.col = static_cast<int>(lines[pos.row].size()) - 1;
+            crossed = true;
+        } else {
+            return pos;
+        }
+
+        // Skip blanks backwards; an empty line stops the motion
+        while (true) {
+            if (pos.col < 0) {
+                if (crossed) {
+                    pos.col = 0;
+                    break;
+                }
+                if (pos.row == 0) {
+                    pos.col = 0;
+                    return pos;
+                }
+                pos.row--;
+                pos.col = static_cast<int>(lines[pos.row].size()) - 1;
+                crossed = true;
+                continue;
+            }
+            if (charClass(lines[pos.row][pos.col]) != CLASS_BLANK) break;
+            pos.col--;
+            crossed = false;
+        }
+
+        // Back to the start of this word
+        const std::string& line = lines[pos.row];
+        if (!line.empty()) {
+            int cls = charClass(line[pos.col]);
+            while (pos.col > 0 && charClass(line[pos.col - 1]) == cls) {
+                pos.col--;
+            }
+        }
+    }
+    return pos;
+}
+
+Position Motions::wordEnd(const Buffer& buffer, Position pos, int count) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    int lastRow = static_cast<int>(lines.size()) - 1;
+    if (pos.row < 0 || pos.row > lastRow) return pos;
+
+    for (int i = 0; i < count; ++i) {
+        Position start = pos;
+        pos.col++;
+
+        // Skip blanks and line ends until a non-blank character
+        while (true) {
+            const std::string& line = lines[pos.row];
+            while (pos.col < static_cast<int>(line.size()) && charClass(line[pos.col]) == CLASS_BLANK) {
+                pos.col++;
+            }
+            if (pos.col < static_cast<int>(line.size())) break;
+            if (pos.row >= lastRow) {
+                return start;
+            }
+            pos.row++;
+            pos.col = 0;
+        }
+
+        const std::string& line = lines[pos.row];
+        int cls = charClass(line[pos.col]);
+        while (pos.col + 1 < static_cast<int>(line.size()) && charClass(line[pos.col + 1]) == cls) {
+            pos.col++;
+        }
+    }
+    return pos;
+}
+
+int Motions::firstNonBlank(const Buffer& buffer, int row) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    if (row < 0 || row >= static_cast<int>(lines.size())) return 0;
+
+    const std::string& line = lines[row];
+    int col = 0;
+    while (col < static_cast<int>(line.size()) && charClass(line[col]) == CLASS_BLANK) {
+        col++;
+    }
+    return col < static_cast<int>(line.size()) ? col : 0;
+}
+
+bool Motions::findChar(const Buffer& buffer, Position pos, char c, int count,
+                       bool forward, bool till, Position& result) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    if (pos.row < 0 || pos.row >= static_cast<int>(lines.size())) return false;
+
+    const std::string& line = lines[pos.row];
+    int col = pos.col;
+    for (int i = 0; i < count; ++i) {
+        // Each occurrence is searched for past the previous one; t/T stop
+        // next to the last, so tx with x right after the cursor stays put
+        int from = col + (forward ? 1 : -1);
+
+        bool found = false;
+        if (forward) {
+            for (int j = from; j < static_cast<int>(line.size()); ++j) {
+                if (line[j] == c) { col = j; found = true; break; }
+            }
+        } else {
+            for (int j = std::min(from, static_cast<int>(line.size()) - 1); j >= 0; --j) {
+                if (line[j] == c) { col = j; found = true; break; }
+            }
+        }
+        if (!found) return false;
+    }
+
+    result.row = pos.row;
+    result.col = till ? col + (forward ? -1 : 1) : col;
+    return true;
+}
+
+bool Motions::word(const Buffer& buffer, Position pos, bool around, Range& range) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    if (pos.row < 0 || pos.row >= static_cast<int>(lines.size())) return false;
+
+    const std::string& line = lines[pos.row];
+    int length = static_cast<int>(line.size());
+    if (pos.col < 0 || pos.col >= length) return false;
+
+    int cls = charClass(line[pos.col]);
+    int start = pos.col;
+    int end = pos.col + 1;
+    while (start > 0 && charClass(line[start - 1]) == cls) start--;
+    while (end < length && charClass(line[end]) == cls) end++;
+
+    if (around) {
+        if (cls == CLASS_BLANK) {
+            // Blanks plus the word after them
+            if (end < length) {
+                int next = charClass(line[end]);
+                while (end < length && charClass(line[end]) == next) end++;
+            }
+        } else if (end < length && charClass(line[end]) == CLASS_BLANK) {
+            while (end < length && charClass(line[end]) == CLASS_BLANK) end++;
+        } else {
+            // No trailing blanks: take the leading ones instead
+            while (start > 0 && charClass(line[start - 1]) == CLASS_BLANK) start--;
+        }
+    }
+
+    range.start.row = pos.row;
+    range.start.col = start;
+    range.end.row = pos.row;
+    range.end.col = end;
+    return true;
+}
+
+} // namespace cvim
@@ -0,0 +1,35 @@
+#ifndef CVIM_MOTIONS_H
+#define CVIM_MOTIONS_H
+
+#include "editor.h"
+#include "../utils/utils.h"
+
+namespace cvim {
+
+// Cursor motions and text objects over a buffer. Unlike the single-line
+// helpers in BufferUtils these cross line boundaries and take a count.
+class Motions {
+public:
+    // w, b, e
+    static Position nextWordStart(const Buffer& buffer, Position pos, int count);
+    static Position prevWordStart(const Buffer& buffer, Position pos, int count);
+    static Position wordEnd(const Buffer& buffer, Position pos, int count);
+
+    // ^
+    static int firstNonBlank(const Buffer& buffer, int row);
+
+    // f, t, F, T: the count'th occurrence of c on the current line
+    static bool findChar(const Buffer& buffer, Position pos, char c, int count,
+                         bool forward, bool till, Position& result);
+
+    // iw / aw: the word (or run of punctuation/blanks) under pos; around
+    // also takes the surrounding white space. The end is exclusive.
+    static bool word(const Buffer& buffer, Position pos, bool around, Range& range);
+
+private:
+    static int charClass(char c);
+};
+
+} // namespace cvim
+
+#endif // CVIM_MOTIONS_H
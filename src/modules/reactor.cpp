@@ -0,0 +1,202 @@
+#include "reactor.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+namespace cvim {
+
+Reactor::Reactor() : epollFd_(-1) {}
+
+Reactor::~Reactor() {
+    // Readers belong to whoever added them; the rest were created here
+    for (std::map<int, Source>::iterator it = sources_.begin(); it != sources_.end(); ++it) {
+        if (it->second.kind != SOURCE_READER) {
+            close(it->first);
+        }
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+bool Reactor::initialize() {
+    if (epollFd_ >= 0) return true;
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    return epollFd_ >= 0;
+}
+
+bool Reactor::add(int fd, SourceKind kind, Callback callback) {
+    if (epollFd_ < 0 || fd < 0) return false;
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return false;
+    }
+
+    Source source;
+    source.kind = kind;
+    source.callback = callback;
+    source.armed = false;
+    sources_[fd] = source;
+    return true;
+}
+
+void Reactor::remove(int fd) {
+    std::map<int, Source>::iterator it = sources_.find(fd);
+    if (it == sources_.end()) return;
+
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, NULL);
+    if (it->second.kind != SOURCE_READER) {
+        close(fd);
+    }
+    sources_.erase(it);
+}
+
+bool Reactor::addReader(int fd, Callback callback) {
+    return add(fd, SOURCE_READER, callback);
+}
+
+void Reactor::removeReader(int fd) {
+    remove(fd);
+}
+
+bool Reactor::addSignal(int signo, Callback callback) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, signo);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0) {
+        return false;
+    }
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) return false;
+    if (!add(fd, SOURCE_SIGNAL, callback)) {
+        close(fd);
+        return false;
+    }
+    return true;
+}
+
+int Reactor::addTimer(Callback callback) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) return -1;
+    if (!add(fd, SOURCE_TIMER, callback)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void Reactor::armTimer(int timer, int milliseconds, bool repeat) {
+    std::map<int, Source>::iterator it = sources_.find(timer);
+    if (it == sources_.end() || it->second.kind != SOURCE_TIMER) return;
+
+    // A zero it_value would disarm the timer instead of firing at once
+    long nanoseconds = std::max(1L, static_cast<long>(milliseconds) * 1000000L);
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = nanoseconds / 1000000000L;
+    spec.it_value.tv_nsec = nanoseconds % 1000000000L;
+    if (repeat) {
+        spec.it_interval = spec.it_value;
+    }
+    timerfd_settime(timer, 0, &spec, NULL);
+    it->second.armed = true;
+}
+
+void Reactor::disarmTimer(int timer) {
+    std::map<int, Source>::iterator it = sources_.find(timer);
+    if (it == sources_.end() || it->second.kind != SOURCE_TIMER) return;
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    timerfd_settime(timer, 0, &spec, NULL);
+    it->second.armed = false;
+}
+
+bool Reactor::isTimerArmed(int timer) const {
+    std::map<int, Source>::const_iterator it = sources_.find(timer);
+    return it != sources_.end() && it->second.armed;
+}
+
+int Reactor::addWakeup(Callback callback) {
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) return -1;
+    if (!add(fd, SOURCE_WAKEUP, callback)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void Reactor::wake(int wakeupFd) {
+    // Safe from any thread; wakeups before the loop reads them coalesce
+    uint64_t one = 1;
+    ssize_t written = write(wakeupFd, &one, sizeof(one));
+    (void)written;
+}
+
+int Reactor::poll(int timeoutMs) {
+    struct epoll_event events[16];
+    int ready = epoll_wait(epollFd_, events, 16, timeoutMs);
+    if (ready < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    int handled = 0;
+    for (int i = 0; i < ready; ++i) {
+        int fd = events[i].data.fd;
+
+        // An earlier callback in this batch may have removed the source
+        std::map<int, Source>::iterator it = sources_.find(fd);
+        if (it == sources_.end()) continue;
+
+        // Drain the fds we own so they do not stay readable
+        switch (it->second.kind) {
+            case SOURCE_SIGNAL: {
+                struct signalfd_siginfo info;
+                while (read(fd, &info, sizeof(info)) == sizeof(info)) {}
+                break;
+            }
+            case SOURCE_TIMER: {
+                uint64_t expirations;
+                if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                    continue;
+                }
+                struct itimerspec spec;
+                if (timerfd_gettime(fd, &spec) == 0 &&
+                    spec.it_interval.tv_sec == 0 && spec.it_interval.tv_nsec == 0) {
+                    it->second.armed = false;
+                }
+                break;
+            }
+            case SOURCE_WAKEUP: {
+                uint64_t count;
+                ssize_t drained = read(fd, &count, sizeof(count));
+                (void)drained;
+                break;
+            }
+            case SOURCE_READER:
+                break;
+        }
+
+        // Copy: the callback may add or remove sources
+        Callback callback = it->second.callback;
+        callback();
+        ++handled;
+    }
+    return handled;
+}
+
+} // namespace cvim
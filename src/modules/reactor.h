@@ -0,0 +1,67 @@
+#ifndef CVIM_REACTOR_H
+#define CVIM_REACTOR_H
+
+#include <map>
+#include <functional>
+
+namespace cvim {
+
+// epoll-based event loop. Every source is a file descriptor: terminal
+// input, signals (signalfd), timers (timerfd), worker wakeups (eventfd) and
+// anything else readable such as inotify. Callbacks run on the loop thread.
+class Reactor {
+public:
+    typedef std::function<void()> Callback;
+
+    Reactor();
+    ~Reactor();
+
+    bool initialize();
+
+    // Call back whenever fd is readable; the callback does the reading
+    bool addReader(int fd, Callback callback);
+    void removeReader(int fd);
+
+    // Deliver signo through a signalfd. The signal is blocked for the
+    // calling thread, so add signals before any other thread is started.
+    bool addSignal(int signo, Callback callback);
+
+    // A timer, idle until armed. Returns its id, or -1.
+    int addTimer(Callback callback);
+    void armTimer(int timer, int milliseconds, bool repeat = false);
+    void disarmTimer(int timer);
+    bool isTimerArmed(int timer) const;
+
+    // An eventfd that any thread may poke with wake(); the callback runs on
+    // the loop. Returns the fd, or -1.
+    int addWakeup(Callback callback);
+    static void wake(int wakeupFd);
+
+    // Wait up to timeoutMs (-1 = forever) and run the callbacks of every
+    // ready source. Returns the number of sources handled.
+    int poll(int timeoutMs);
+
+private:
+    enum SourceKind {
+        SOURCE_READER,
+        SOURCE_SIGNAL,
+        SOURCE_TIMER,
+        SOURCE_WAKEUP
+    };
+
+    struct Source {
+        SourceKind kind;
+        Callback callback;
+        bool armed;
+    };
+
+    bool add(int fd, SourceKind kind, Callback callback);
+    void remove(int fd);
+
+    int epollFd_;
+    std::map<int, Source> sources_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_REACTOR_H
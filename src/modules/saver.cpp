@@ -0,0 +1,128 @@
+#include "saver.h"
+#include "editor.h"
+#include "journal.h"
+#include "threadpool.h"
+#include "../utils/fileio.h"
+#include <sstream>
+
+namespace cvim {
+
+AsyncSaver::AsyncSaver(ThreadPool* pool)
+    : pool_(pool), busy_(false), finished_(false), bytesWritten_(0), totalBytes_(0),
+      success_(false), changeTick_(0), journalMark_(0), lineCount_(0) {}
+
+AsyncSaver::~AsyncSaver() {
+    wait();
+}
+
+bool AsyncSaver::start(const std::shared_ptr<Buffer>& buffer, const std::string& path) {
+    if (!buffer || path.empty() || busy_) return false;
+
+    buffer_ = buffer;
+    changeTick_ = buffer->getChangeTick();
+    std::shared_ptr<Journal> journal = buffer->getJournal();
+    journalMark_ = journal ? journal->mark() : 0;
+    path_ = path;
+
+    std::shared_ptr<const std::vector<std::string> > lines = buffer->snapshot();
+    lineCount_ = lines->size();
+    bytesWritten_ = 0;
+    totalBytes_ = 0;
+    finished_ = false;
+    busy_ = true;
+
+    // The completion only wakes the main loop, which then calls poll()
+    pool_->submit(ThreadPool::PRIORITY_BACKGROUND,
+                  [this, lines, path](const CancelToken&) { run(lines, path); },
+                  [](bool) {});
+    
+    // The first edit during the write needs lines of its own. They are
+    // copied here on a worker rather than on that keystroke; an edit that
+    // comes before the copy is ready still copies for itself.
+    std::weak_ptr<Buffer> owner = buffer;
+    std::shared_ptr<std::shared_ptr<std::vector<std::string> > > copy =
+        std::make_shared<std::shared_ptr<std::vector<std::string> > >();
+    pool_->submit(ThreadPool::PRIORITY_BACKGROUND,
+                  [lines, copy](const CancelToken&) {
+                      *copy = std::make_shared<std::vector<std::string> >(*lines);
+                  },
+                  [owner, lines, copy](bool cancelled) {
+                      std::shared_ptr<Buffer> buffer = owner.lock();
+                      if (buffer && !cancelled) buffer->adoptCopy(lines, *copy);
+                  });
+    return true;
+}
+
+bool AsyncSaver::isBusy() const {
+    return busy_;
+}
+
+int AsyncSaver::getProgress() const {
+    size_t total = totalBytes_;
+    if (total == 0) return 0;
+    return static_cast<int>(bytesWritten_ * 100 / total);
+}
+
+const std::string& AsyncSaver::getPath() const {
+    return path_;
+}
+
+std::shared_ptr<Buffer> AsyncSaver::getBuffer() const {
+    return buffer_.lock();
+}
+
+bool AsyncSaver::poll(std::string& message) {
+    if (!finished_) return false;
+
+    finished_ = false;
+    busy_ = false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::stringstream ss;
+    if (success_) {
+        // Edits made while writing keep the buffer marked modified
+        std::shared_ptr<Buffer> buffer = buffer_.lock();
+        if (buffer && buffer->getFilePath() == path_) {
+            buffer->markSaved(changeTick_);
+            // Only records made after the snapshot still need replaying
+            std::shared_ptr<Journal> journal = buffer->getJournal();
+            if (journal) {
+                journal->rebase(journalMark_);
+            }
+        }
+        ss << "\"" << path_ << "\" " << lineCount_ << "L, " << bytesWritten_ << "B written";
+    } else {
+        ss << "Save failed: " << error_;
+    }
+    message = ss.str();
+    return true;
+}
+
+void AsyncSaver::wait() {
+    if (!busy_) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return finished_.load(); });
+}
+
+void AsyncSaver::run(std::shared_ptr<const std::vector<std::string> > lines, std::string path) {
+    size_t total = 0;
+    for (size_t i = 0; i < lines->size(); ++i) {
+        total += (*lines)[i].size() + 1;
+    }
+    totalBytes_ = total;
+
+    Result result = writeLinesAtomic(path, *lines, [this](size_t written) {
+        bytesWritten_ = written;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        success_ = result.isSuccess();
+        error_ = result.getError();
+        finished_ = true;
+    }
+    done_.notify_all();
+}
+
+} // namespace cvim
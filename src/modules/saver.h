@@ -0,0 +1,63 @@
+#ifndef CVIM_SAVER_H
+#define CVIM_SAVER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace cvim {
+
+class Buffer;
+class ThreadPool;
+
+// Writes buffer snapshots on the editor's thread pool so :w never blocks
+// input. Only one save runs at a time; the main loop polls for completion.
+class AsyncSaver {
+public:
+    explicit AsyncSaver(ThreadPool* pool);
+    ~AsyncSaver();
+
+    // Snapshot the buffer and start writing it to path
+    bool start(const std::shared_ptr<Buffer>& buffer, const std::string& path);
+    bool isBusy() const;
+
+    // Progress of the running save in percent (0-100)
+    int getProgress() const;
+    const std::string& getPath() const;
+    // Buffer of the current or last save, if it is still alive
+    std::shared_ptr<Buffer> getBuffer() const;
+
+    // Returns true once per finished save, with a message for the status line
+    bool poll(std::string& message);
+
+    // Block until the running save (if any) has finished
+    void wait();
+
+private:
+    void run(std::shared_ptr<const std::vector<std::string> > lines, std::string path);
+
+    ThreadPool* pool_;
+    std::atomic<bool> busy_;
+    std::atomic<bool> finished_;
+    std::atomic<size_t> bytesWritten_;
+    std::atomic<size_t> totalBytes_;
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+    bool success_;
+    std::string error_;
+
+    // Owned by the main thread
+    std::weak_ptr<Buffer> buffer_;
+    unsigned long changeTick_;
+    size_t journalMark_;
+    size_t lineCount_;
+    std::string path_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_SAVER_H
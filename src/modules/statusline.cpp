@@ -0,0 +1,99 @@
+#include "statusline.h"
+#include <cstdio>
+
+namespace cvim {
+
+StatusLine::StatusLine()
+    : mode_(""), modified_(false), savePercent_(-1), recording_(0),
+      row_(0), lineCount_(1), col_(0), dirty_(true) {
+    save_[0] = '\0';
+    snprintf(position_, sizeof(position_), " - Line 1/1 Col 1");
+    text_.reserve(256);
+}
+
+void StatusLine::setMode(const char* mode) {
+    if (mode == mode_) return;
+    mode_ = mode;
+    dirty_ = true;
+}
+
+void StatusLine::setFile(const std::string& path, bool modified) {
+    if (path == path_ && modified == modified_) return;
+    path_ = path;
+    modified_ = modified;
+    dirty_ = true;
+}
+
+void StatusLine::setSaveProgress(int percent) {
+    if (percent == savePercent_) return;
+    savePercent_ = percent;
+    if (percent < 0) {
+        save_[0] = '\0';
+    } else {
+        snprintf(save_, sizeof(save_), " [writing %d%%]", percent);
+    }
+    dirty_ = true;
+}
+
+void StatusLine::setRecording(char reg) {
+    if (reg == recording_) return;
+    recording_ = reg;
+    dirty_ = true;
+}
+
+void StatusLine::setPosition(int row, size_t lineCount, int col) {
+    if (row == row_ && lineCount == lineCount_ && col == col_) return;
+    row_ = row;
+    lineCount_ = lineCount;
+    col_ = col;
+    snprintf(position_, sizeof(position_), " - Line %d/%lu Col %d",
+             row + 1, static_cast<unsigned long>(lineCount), col + 1);
+    dirty_ = true;
+}
+
+void StatusLine::setMessage(const std::string& message) {
+    if (message == message_) return;
+    message_ = message;
+    dirty_ = true;
+}
+
+void StatusLine::setPerf(const char* text) {
+    if (perf_ == text) return;
+    perf_ = text;
+    dirty_ = true;
+}
+
+const std::string& StatusLine::getText() {
+    if (dirty_) {
+        assemble();
+        dirty_ = false;
+    }
+    return text_;
+}
+
+void StatusLine::assemble() {
+    text_.clear();
+    text_ += '[';
+    text_ += mode_;
+    text_ += "] ";
+    text_ += path_.empty() ? "[No Name]" : path_.c_str();
+    if (modified_) {
+        text_ += " [+]";
+    }
+    text_ += save_;
+    if (recording_) {
+        text_ += " recording @";
+        text_ += recording_;
+    }
+    text_ += position_;
+    if (!message_.empty()) {
+        text_ += " | ";
+        text_ += message_;
+    }
+    if (!perf_.empty()) {
+        text_ += " | ";
+        text_ += perf_;
+    }
+}
+
+} // namespace cvim
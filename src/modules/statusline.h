@@ -0,0 +1,58 @@
+#ifndef CVIM_STATUSLINE_H
+#define CVIM_STATUSLINE_H
+
+#include <string>
+#include <cstddef>
+
+namespace cvim {
+
+// The status line as segments:
+//   [MODE] path [+] [writing N%] recording @r - Line R/N Col C | message | perf
+// Every setter compares with what is shown and only marks the line for
+// reassembly when something changed; numbers are formatted only then.
+// The line is built in a buffer kept between frames, so once the buffers
+// have grown to fit, updating it does not allocate.
+class StatusLine {
+public:
+    StatusLine();
+
+    // mode must be a string literal
+    void setMode(const char* mode);
+    void setFile(const std::string& path, bool modified);
+    // Negative when no background save is running
+    void setSaveProgress(int percent);
+    // 0 when no macro is being recorded
+    void setRecording(char reg);
+    // Zero-based cursor position
+    void setPosition(int row, size_t lineCount, int col);
+    void setMessage(const std::string& message);
+    // The :set showperf figures; empty for none
+    void setPerf(const char* text);
+
+    const std::string& getText();
+
+private:
+    void assemble();
+
+    const char* mode_;
+    std::string path_;
+    bool modified_;
+    int savePercent_;
+    char recording_;
+    int row_;
+    size_t lineCount_;
+    int col_;
+    std::string message_;
+    std::string perf_;
+
+    // Formatted segments
+    char save_[24];
+    char position_[64];
+
+    std::string text_;
+    bool dirty_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_STATUSLINE_H
@@ -1,10 +1,11 @@
 #include "tabs.h"
 #include "editor.h"
 #include "../utils/utils.h"
+#include <algorithm>
 
 namespace cvim {
 
-TabManager::TabManager() : currentTab_(-1) {}
+TabManager::TabManager() : useClock_(0), memoryBudget_(0), currentTab_(-1) {}
 
 TabManager::~TabManager() {}
 
@@ -14,14 +15,27 @@ bool TabManager::isEmpty() const {
 
 void TabManager::addTab(const std::shared_ptr<Buffer>& buffer) {
     tabs_.push_back(buffer);
+    lastUsed_.push_back(0);
+    touch(tabs_.size() - 1);
     if (currentTab_ < 0) {
         currentTab_ = 0;
     }
+    // The budget is enforced once the caller switches to the new tab;
+    // doing it here could evict the buffer that was just read
+}
+
+void TabManager::replaceTab(int index, const std::shared_ptr<Buffer>& buffer) {
+    if (index >= 0 && index < static_cast<int>(tabs_.size())) {
+        tabs_[index] = buffer;
+        touch(index);
+        enforceMemoryBudget();
+    }
 }
 
 void TabManager::removeTab(int index) {
     if (index >= 0 && index < static_cast<int>(tabs_.size())) {
         tabs_.erase(tabs_.begin() + index);
+        lastUsed_.erase(lastUsed_.begin() + index);
         
         // Adjust current tab index
         if (currentTab_ >= static_cast<int>(tabs_.size())) {
@@ -30,29 +44,41 @@ void TabManager::removeTab(int index) {
     }
 }
 
-void TabManager::switchTab(int index) {
-    if (index >= 0 && index < static_cast<int>(tabs_.size())) {
-        currentTab_ = index;
-    }
+bool TabManager::switchTab(int index) {
+    if (index < 0 || index >= static_cast<int>(tabs_.size())) return false;
+    
+    // Transparently bring an evicted buffer back. If that fails, showing
+    // its placeholder under the file's name would invite saving it.
+    if (!tabs_[index]->ensureLoaded()) return false;
+    currentTab_ = index;
+    touch(index);
+    enforceMemoryBudget();
+    return true;
 }
 
-void TabManager::nextTab() {
-    if (!tabs_.empty()) {
-        currentTab_ = (currentTab_ + 1) % tabs_.size();
-    }
+bool TabManager::nextTab() {
+    if (tabs_.empty()) return false;
+    return switchTab((currentTab_ + 1) % tabs_.size());
+}
+
+bool TabManager::prevTab() {
+    if (tabs_.empty()) return false;
+    return switchTab((currentTab_ + tabs_.size() - 1) % tabs_.size());
 }
 
-void TabManager::prevTab() {
-    if (!tabs_.empty()) {
-        currentTab_ = (currentTab_ + tabs_.size() - 1) % tabs_.size();
+std::shared_ptr<Buffer> TabManager::getBuffer(int index) const {
+    if (index >= 0 && index < static_cast<int>(tabs_.size())) {
+        return tabs_[index];
     }
+    return nullptr;
 }
 
-std::shared_ptr<Buffer> TabManager::getCurrentBuffer() const {
+const std::shared_ptr<Buffer>& TabManager::getCurrentBuffer() const {
+    static const std::shared_ptr<Buffer> none;
     if (currentTab_ >= 0 && currentTab_ < static_cast<int>(tabs_.size())) {
         return tabs_[currentTab_];
     }
-    return nullptr;
+    return none;
 }
 
 int TabManager::getCurrentIndex() const {
@@ -63,6 +89,15 @@ int TabManager::getTabCount() const {
     return tabs_.size();
 }
 
+int TabManager::findTab(const std::shared_ptr<Buffer>& buffer) const {
+    for (size_t i = 0; i < tabs_.size(); ++i) {
+        if (tabs_[i] == buffer) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
 std::vector<std::string> TabManager::getTabNames() const {
     std::vector<std::string> names;
     // Use traditional for loop instead of range-based for
@@ -79,4 +114,47 @@ std::vector<std::string> TabManager::getTabNames() const {
     return names;
 }
 
+void TabManager::setMemoryBudget(size_t bytes) {
+    memoryBudget_ = bytes;
+    enforceMemoryBudget();
+}
+
+size_t TabManager::getMemoryBudget() const {
+    return memoryBudget_;
+}
+
+void TabManager::enforceMemoryBudget() {
+    if (memoryBudget_ == 0) return;
+    
+    size_t total = 0;
+    for (size_t i = 0; i < tabs_.size(); ++i) {
+        if (tabs_[i]->isResident()) {
+            total += tabs_[i]->getResidentBytes();
+        }
+    }
+    if (total <= memoryBudget_) return;
+    
+    // Oldest first
+    std::vector<int> order;
+    for (size_t i = 0; i < tabs_.size(); ++i) {
+        order.push_back(static_cast<int>(i));
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return lastUsed_[a] < lastUsed_[b];
+    });
+    
+    for (size_t i = 0; i < order.size() && total > memoryBudget_; ++i) {
+        const std::shared_ptr<Buffer>& buffer = tabs_[order[i]];
+        if (order[i] == currentTab_ || !buffer->canEvict()) {
+            continue;
+        }
+        total -= buffer->getResidentBytes();
+        buffer->evict();
+    }
+}
+
+void TabManager::touch(int index) {
+    lastUsed_[index] = ++useClock_;
+}
+
 } // namespace cvim
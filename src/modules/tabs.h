@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstddef>
 
 namespace cvim {
 
@@ -16,19 +17,37 @@ public:
     
     bool isEmpty() const;
     void addTab(const std::shared_ptr<Buffer>& buffer);
+    void replaceTab(int index, const std::shared_ptr<Buffer>& buffer);
     void removeTab(int index);
-    void switchTab(int index);
-    void nextTab();
-    void prevTab();
+    // False, staying on the current tab, if an evicted buffer cannot be
+    // read back in
+    bool switchTab(int index);
+    bool nextTab();
+    bool prevTab();
     
-    std::shared_ptr<Buffer> getCurrentBuffer() const;
+    // By reference: looked up on every keystroke, so no refcount traffic
+    const std::shared_ptr<Buffer>& getCurrentBuffer() const;
+    std::shared_ptr<Buffer> getBuffer(int index) const;
     int getCurrentIndex() const;
     int getTabCount() const;
+    // Index of the tab showing buffer, or -1
+    int findTab(const std::shared_ptr<Buffer>& buffer) const;
     
     std::vector<std::string> getTabNames() const;
     
+    // Bytes of buffer contents kept in memory; 0 disables eviction
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const;
+    // Evict least recently used inactive buffers until under budget
+    void enforceMemoryBudget();
+    
 private:
+    void touch(int index);
+    
     std::vector<std::shared_ptr<Buffer> > tabs_;
+    std::vector<unsigned long> lastUsed_;  // LRU clock per tab
+    unsigned long useClock_;
+    size_t memoryBudget_;
     int currentTab_;
 };
 
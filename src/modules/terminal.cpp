@@ -1,43 +1,61 @@
 #include "terminal.h"
-#include <iostream>
+#include "../utils/profiler.h"
+#include "../utils/unicode.h"
+#include <ostream>
+#include <cerrno>
+#include <cstdio>
 #include <unistd.h>
 #include <termios.h>
 #include <sys/ioctl.h>
 #include <cstring>
-#include <signal.h>
+#include <poll.h>
 #include <stdexcept>
+#include <algorithm>
 
 namespace cvim {
 
-static Terminal* globalTerminalInstance = nullptr;
+// How long the rest of an escape sequence may lag behind the ESC byte
+static const int ESCAPE_TIMEOUT_MS = 30;
 
-static void handleSigWinch(int sig) {
-    if (globalTerminalInstance) {
-        globalTerminalInstance->refreshScreen();
-    }
+// Read one byte, waiting up to timeoutMs for it to arrive
+static bool readWithTimeout(char* c, int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, timeoutMs) <= 0) return false;
+    return read(STDIN_FILENO, c, 1) == 1;
 }
 
-Terminal::Terminal() : rawMode_(false), originalTerminalState_(-1) {
-    globalTerminalInstance = this;
+// Mode 2026 makes the terminal hold the screen until the whole frame has
+// arrived; terminals without it ignore the unknown mode. The cursor is
+// hidden while drawing for those.
+static const char BEGIN_FRAME[] = "\x1b[?2026h\x1b[?25l";
+static const char END_FRAME[] = "\x1b[?25h\x1b[?2026l";
+
+// Where a row can be split for a partial redraw: either end, or between
+// two ASCII bytes, which never belong to the same character
+static bool isCellBoundary(const std::string& text, size_t pos) {
+    return pos == 0 || pos >= text.size() ||
+           (static_cast<unsigned char>(text[pos]) < 0x80 && static_cast<unsigned char>(text[pos - 1]) < 0x80);
+}
+
+Terminal::Terminal() : rawMode_(false), originalTerminalState_(-1), out_(nullptr), bytesWritten_(0) {
+    size_.height = 24;
+    size_.width = 80;
+    frame_.reserve(64 * 1024);
 }
 
 Terminal::~Terminal() {
     shutdown();
-    globalTerminalInstance = nullptr;
 }
 
 bool Terminal::initialize() {
     setupTerminal();
     
-    // Setup resize handler
-    struct sigaction sa;
-    memset(&sa, 0, sizeof(sa));
-    sa.sa_handler = handleSigWinch;
-    sigaction(SIGWINCH, &sa, NULL);
-    
     // Get initial terminal size
     handleResize();
     clearScreen();
+    refreshScreen();
     return true;
 }
 
@@ -57,8 +75,9 @@ void Terminal::setupTerminal() {
     raw.c_oflag &= ~(OPOST);
     raw.c_cflag |= (CS8);
     raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    // Never block: the main loop only reads once poll says input is there
     raw.c_cc[VMIN] = 0;
-    raw.c_cc[VTIME] = 1;
+    raw.c_cc[VTIME] = 0;
     
     if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) < 0) {
         throw std::runtime_error("Could not set terminal attributes");
@@ -84,9 +103,11 @@ void Terminal::shutdown() {
     restoreTerminal();
     clearScreen();
     setCursor(0, 0);
+    refreshScreen();
 }
 
 KeyInput Terminal::getInput() {
+    PROFILE_SCOPE("Terminal::getInput");
     KeyInput input;
     input.key = UNKNOWN;
     input.character = 0;
@@ -98,12 +119,12 @@ KeyInput Terminal::getInput() {
     if (read(STDIN_FILENO, &c, 1) == 1) {
         if (c == 27) { // ESC sequence
             char seq[3];
-            if (read(STDIN_FILENO, &seq[0], 1) != 1) {
+            if (!readWithTimeout(&seq[0], ESCAPE_TIMEOUT_MS)) {
                 input.key = ESCAPE;
                 input.character = 27;
                 return input;
             }
-            if (read(STDIN_FILENO, &seq[1], 1) != 1) {
+            if (!readWithTimeout(&seq[1], ESCAPE_TIMEOUT_MS)) {
                 input.key = ESCAPE;
                 input.character = 27;
                 return input;
@@ -111,7 +132,7 @@ KeyInput Terminal::getInput() {
             
             if (seq[0] == '[') {
                 if (seq[1] >= '0' && seq[1] <= '9') {
-                    if (read(STDIN_FILENO, &seq[2], 1) != 1) return input;
+                    if (!readWithTimeout(&seq[2], ESCAPE_TIMEOUT_MS)) return input;
                     if (seq[2] == '~') {
                         switch (seq[1]) {
                             case '1': input.key = HOME; return input;
@@ -159,24 +180,30 @@ KeyInput Terminal::getInput() {
 }
 
 void Terminal::render(const ViewData& viewData) {
-    clearScreen();
-    
-    // Render text content
-    size_t visibleLines = size_.height - 2; // Reserve space for status and command line
-    for (size_t i = 0; i < viewData.lines.size() && i < visibleLines; i++) {
-        std::cout << viewData.lines[i] << "\r\n";
+    PROFILE_SCOPE("Terminal::render");
+    frame_.append(BEGIN_FRAME, sizeof(BEGIN_FRAME) - 1);
+    if (static_cast<int>(shown_.size()) != size_.height) {
+        // Resized, or nothing drawn yet
+        clearScreen();
     }
     
-    // Render status line
-    setCursor(size_.height - 2, 0);
-    std::cout << viewData.statusLine;
+    // Text rows, then the status and command lines; only what differs from
+    // the last frame is sent
+    static const std::string EMPTY;
+    int visibleLines = size_.height - 2;
+    for (int row = 0; row < visibleLines; ++row) {
+        drawRow(row, row < static_cast<int>(viewData.lines.size()) ? viewData.lines[row] : EMPTY);
+    }
+    drawRow(size_.height - 2, viewData.statusLine);
     
-    // Render command line
-    setCursor(size_.height - 1, 0);
-    std::cout << viewData.mode << " " << viewData.commandLine;
+    commandRow_ = viewData.mode;
+    commandRow_ += ' ';
+    commandRow_ += viewData.commandLine;
+    drawRow(size_.height - 1, commandRow_);
     
     // Set cursor to editing position
     setCursor(viewData.cursorRow, viewData.cursorCol);
+    frame_.append(END_FRAME, sizeof(END_FRAME) - 1);
     
     refreshScreen();
 }
@@ -186,16 +213,117 @@ Size Terminal::getSize() const {
 }
 
 void Terminal::setCursor(int row, int col) {
-    std::cout << "\x1b[" << (row + 1) << ";" << (col + 1) << "H";
+    char sequence[32];
+    int length = snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", row + 1, col + 1);
+    frame_.append(sequence, length);
 }
 
 void Terminal::clearScreen() {
-    std::cout << "\x1b[2J\x1b[H";
+    frame_ += "\x1b[2J\x1b[H";
+    shown_.assign(size_.height > 0 ? size_.height : 0, std::string());
+}
+
+const std::string& Terminal::fitWidth(const std::string& text, int width) {
+    // No character takes more cells than bytes, except a tab
+    if (text.size() <= static_cast<size_t>(std::max(0, width)) && text.find('\t') == std::string::npos) {
+        return text;
+    }
+    size_t end = byteAtColumn(text, width, 8);
+    if (end >= text.size()) return text;
+    clipped_.assign(text, 0, end);
+    return clipped_;
+}
+
+void Terminal::drawRow(int row, const std::string& fullText) {
+    if (row < 0 || row >= static_cast<int>(shown_.size())) return;
+    // Past the right edge the terminal wraps onto the next row, which
+    // shown_ knows nothing about. The bottom row keeps its last cell
+    // free: filling it scrolls the screen on some terminals.
+    int width = row == size_.height - 1 ? size_.width - 1 : size_.width;
+    const std::string& text = fitWidth(fullText, width);
+    std::string& shown = shown_[row];
+    if (text == shown) return;
+    
+    // Leave alone what is already on screen at either end of the row
+    size_t common = std::min(text.size(), shown.size());
+    size_t prefix = 0;
+    while (prefix < common && text[prefix] == shown[prefix]) {
+        ++prefix;
+    }
+    while (prefix > 0 && !(isCellBoundary(text, prefix) && isCellBoundary(shown, prefix))) {
+        --prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < common - prefix && text[text.size() - 1 - suffix] == shown[shown.size() - 1 - suffix]) {
+        ++suffix;
+    }
+    while (suffix > 0 && !(isCellBoundary(text, text.size() - suffix) &&
+                           isCellBoundary(shown, shown.size() - suffix))) {
+        --suffix;
+    }
+    
+    // Rows arrive with tabs expanded, so the tab size does not matter here
+    int column = displayColumn(text, prefix, 8);
+    int newEnd = displayColumn(text, text.size() - suffix, 8, prefix, column);
+    int oldEnd = displayColumn(shown, shown.size() - suffix, 8, prefix, column);
+    if (newEnd != oldEnd) {
+        // The unchanged tail would move: draw it again
+        suffix = 0;
+        newEnd = displayColumn(text, text.size(), 8, prefix, column);
+        oldEnd = displayColumn(shown, shown.size(), 8, prefix, column);
+    }
+    
+    setCursor(row, column);
+    frame_.append(text, prefix, text.size() - suffix - prefix);
+    if (suffix == 0 && newEnd < oldEnd) {
+        frame_ += "\x1b[K";
+    }
+    shown = text;
 }
 
 void Terminal::refreshScreen() {
-    std::cout.flush();
-    handleResize();
+    if (frame_.empty()) return;
+    bytesWritten_ += static_cast<long long>(frame_.size());
+    
+    if (out_) {
+        out_->write(frame_.data(), frame_.size());
+        out_->flush();
+    } else {
+        // One write, unless the terminal takes the frame in pieces
+        const char* data = frame_.data();
+        size_t left = frame_.size();
+        while (left > 0) {
+            ssize_t written = write(STDOUT_FILENO, data, left);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN) {
+                    struct pollfd pfd;
+                    pfd.fd = STDOUT_FILENO;
+                    pfd.events = POLLOUT;
+                    poll(&pfd, 1, -1);
+                    continue;
+                }
+                break;
+            }
+            data += written;
+            left -= static_cast<size_t>(written);
+        }
+    }
+    // Keeps its capacity for the next frame
+    frame_.clear();
+}
+
+void Terminal::setOutput(std::ostream* out) {
+    out_ = out;
+}
+
+void Terminal::setSize(const Size& size) {
+    size_ = size;
+    shown_.clear();
+}
+
+long long Terminal::getBytesWritten() const {
+    return bytesWritten_;
 }
 
 void Terminal::handleResize() {
@@ -206,6 +334,8 @@ void Terminal::handleResize() {
     } else {
         size_ = {ws.ws_row, ws.ws_col};
     }
+    // Redraw everything at the new size
+    shown_.clear();
 }
 
 } // namespace cvim
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <iosfwd>
 #include "../utils/utils.h"
 
 namespace cvim {
@@ -92,18 +93,41 @@ public:
     void render(const ViewData& viewData);
     
     Size getSize() const;
+    // Frames are composed in a buffer; refreshScreen() sends it all at once.
+    // render() remembers what each row shows and sends only the cells that
+    // changed; clearScreen() or a new size makes the next frame draw all.
     void setCursor(int row, int col);
     void clearScreen();
     void refreshScreen();
 
+    // Re-read the window size; called by the main loop on SIGWINCH
+    void handleResize();
+    
+    // Render to a stream instead of stdout (e.g. an in-memory terminal for
+    // replays), at a fixed size
+    void setOutput(std::ostream* out);
+    void setSize(const Size& size);
+
+    // Bytes sent to the output so far, for the frame size in :set showperf
+    long long getBytesWritten() const;
+
 private:
     void setupTerminal();
     void restoreTerminal();
-    void handleResize();
+    // Bring one screen row from what it shows to text, cut to fit
+    void drawRow(int row, const std::string& text);
+    // text, or its first cells that fit in width (held in clipped_)
+    const std::string& fitWidth(const std::string& text, int width);
     
     bool rawMode_;
     Size size_;
     int originalTerminalState_;
+    std::ostream* out_;  // null: write to stdout
+    std::string frame_;
+    long long bytesWritten_;
+    std::vector<std::string> shown_; // what each row shows now
+    std::string commandRow_;
+    std::string clipped_;
 };
 
 } // namespace cvim
@@ -0,0 +1,185 @@
+#include "threadpool.h"
+
+namespace cvim {
+
+// Worker index of the calling thread within its pool, so jobs submitted
+// from a job land on the same worker's deque
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+CancelToken::CancelToken() : flag_(std::make_shared<std::atomic<bool> >(false)) {}
+
+void CancelToken::cancel() {
+    *flag_ = true;
+}
+
+bool CancelToken::isCancelled() const {
+    return *flag_;
+}
+
+ThreadPool::ThreadPool(int workers)
+    : nextWorker_(0), queued_(0), stopping_(false),
+      submitted_(0), completed_(0), cancelled_(0), stolen_(0) {
+    if (workers <= 0) {
+        workers = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (workers <= 0) {
+        workers = 2;
+    }
+
+    for (int i = 0; i < workers; ++i) {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    // Start only once every deque exists, since workers steal from all of them
+    for (int i = 0; i < workers; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        if (workers_[i]->thread.joinable()) {
+            workers_[i]->thread.join();
+        }
+    }
+}
+
+CancelToken ThreadPool::submit(Priority priority, Work work, Completion done) {
+    Job job;
+    job.work = work;
+    job.done = done;
+    CancelToken token = job.token;
+
+    int index = currentPool == this ? currentWorker
+                                    : static_cast<int>(nextWorker_++ % workers_.size());
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->queues[priority].push_back(job);
+    }
+    ++submitted_;
+    ++queued_;
+
+    // Taking the lock orders this against a worker checking queued_
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wakeup_.notify_one();
+    return token;
+}
+
+void ThreadPool::setNotifier(std::function<void()> notify) {
+    notify_ = notify;
+}
+
+int ThreadPool::runCompletions() {
+    std::vector<std::pair<Completion, bool> > ready;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        ready.swap(completions_);
+    }
+    for (size_t i = 0; i < ready.size(); ++i) {
+        ready[i].first(ready[i].second);
+    }
+    return static_cast<int>(ready.size());
+}
+
+ThreadPool::Stats ThreadPool::getStats() const {
+    Stats stats;
+    stats.workers = getWorkerCount();
+    stats.submitted = submitted_;
+    stats.completed = completed_;
+    stats.cancelled = cancelled_;
+    stats.stolen = stolen_;
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        stats.queued[p] = 0;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+            stats.queued[p] += static_cast<int>(workers_[i]->queues[p].size());
+        }
+    }
+    return stats;
+}
+
+int ThreadPool::getWorkerCount() const {
+    return static_cast<int>(workers_.size());
+}
+
+void ThreadPool::workerLoop(int index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        Job job;
+        if (takeJob(index, job)) {
+            runJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wakeup_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::takeJob(int index, Job& job) {
+    int count = static_cast<int>(workers_.size());
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        // Own deque first, newest job while its data is still warm
+        {
+            Worker& own = *workers_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.queues[p].empty()) {
+                job = own.queues[p].back();
+                own.queues[p].pop_back();
+                --queued_;
+                return true;
+            }
+        }
+
+        // Then steal the oldest job of this priority from the others
+        for (int i = 1; i < count; ++i) {
+            Worker& victim = *workers_[(index + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queues[p].empty()) {
+                job = victim.queues[p].front();
+                victim.queues[p].pop_front();
+                --queued_;
+                ++stolen_;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runJob(Job& job) {
+    if (!job.token.isCancelled()) {
+        job.work(job.token);
+    }
+
+    bool cancelled = job.token.isCancelled();
+    if (cancelled) {
+        ++cancelled_;
+    } else {
+        ++completed_;
+    }
+
+    if (job.done) {
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completions_.push_back(std::make_pair(job.done, cancelled));
+        }
+        if (notify_) {
+            notify_();
+        }
+    }
+}
+
+} // namespace cvim
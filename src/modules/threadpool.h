@@ -0,0 +1,107 @@
+#ifndef CVIM_THREADPOOL_H
+#define CVIM_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+namespace cvim {
+
+// Shared flag a job polls to stop early. Copies refer to the same flag.
+class CancelToken {
+public:
+    CancelToken();
+
+    void cancel();
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool> > flag_;
+};
+
+// Editor-wide work-stealing pool for background jobs (saving, searching,
+// indexing...). Every worker owns a deque per priority: it pops its own
+// newest job and steals the oldest from the others when it runs dry.
+// Completions are handed back to the main loop, never run on a worker.
+class ThreadPool {
+public:
+    enum Priority {
+        PRIORITY_INTERACTIVE, // the user is waiting for the result
+        PRIORITY_VIEWPORT,    // affects what is on screen
+        PRIORITY_BACKGROUND,  // everything else
+        PRIORITY_COUNT
+    };
+
+    typedef std::function<void(const CancelToken&)> Work;
+    // Runs on the main loop; cancelled is set if the work was skipped or stopped
+    typedef std::function<void(bool cancelled)> Completion;
+
+    struct Stats {
+        int workers;
+        unsigned long submitted;
+        unsigned long completed;
+        unsigned long cancelled;
+        unsigned long stolen;
+        int queued[PRIORITY_COUNT];
+    };
+
+    // workers <= 0 picks one per hardware thread
+    explicit ThreadPool(int workers = 0);
+    // Runs the jobs still queued, then joins the workers
+    ~ThreadPool();
+
+    CancelToken submit(Priority priority, Work work, Completion done = Completion());
+
+    // Called from a worker whenever a completion is queued, e.g. to poke
+    // the main loop's eventfd. Set before the first submit().
+    void setNotifier(std::function<void()> notify);
+
+    // Run the queued completions; main thread only. Returns how many ran.
+    int runCompletions();
+
+    Stats getStats() const;
+    int getWorkerCount() const;
+
+private:
+    struct Job {
+        Work work;
+        Completion done;
+        CancelToken token;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> queues[PRIORITY_COUNT];
+        std::thread thread;
+    };
+
+    void workerLoop(int index);
+    bool takeJob(int index, Job& job);
+    void runJob(Job& job);
+
+    std::vector<std::unique_ptr<Worker> > workers_;
+    std::atomic<unsigned> nextWorker_;
+    std::atomic<int> queued_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wakeup_;
+    bool stopping_;
+
+    std::mutex completionMutex_;
+    std::vector<std::pair<Completion, bool> > completions_;
+    std::function<void()> notify_;
+
+    std::atomic<unsigned long> submitted_;
+    std::atomic<unsigned long> completed_;
+    std::atomic<unsigned long> cancelled_;
+    std::atomic<unsigned long> stolen_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_THREADPOOL_H
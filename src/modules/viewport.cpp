@@ -0,0 +1,265 @@
+#include "viewport.h"
+#include "editor.h"
+#include "../utils/unicode.h"
+#include <algorithm>
+
+namespace cvim {
+
+Viewport::Viewport()
+    : height_(22), width_(80), textWidth_(80), tabSize_(4), wrap_(false),
+      topLine_(0), topRow_(0), leftColumn_(0), sideScroll_(0) {}
+
+void Viewport::setSize(int height, int width) {
+    height_ = std::max(1, height);
+    width_ = std::max(1, width);
+}
+
+void Viewport::setWrap(bool wrap) {
+    if (wrap != wrap_) {
+        topRow_ = 0;
+        leftColumn_ = 0;
+    }
+    wrap_ = wrap;
+}
+
+void Viewport::setTabSize(int tabSize) {
+    tabSize_ = std::max(1, tabSize);
+}
+
+void Viewport::setGutter(bool numbers, bool relative) {
+    gutter_.setMode(numbers, relative);
+}
+
+void Viewport::setSideScroll(int columns) {
+    sideScroll_ = std::max(0, columns);
+}
+
+void Viewport::reset() {
+    topLine_ = 0;
+    topRow_ = 0;
+    leftColumn_ = 0;
+}
+
+void Viewport::scrollColumns(int columns) {
+    if (wrap_) return;
+    leftColumn_ = std::max(0, leftColumn_ + columns);
+}
+
+Position Viewport::keepInView(const Buffer& buffer, const Position& pos) const {
+    if (wrap_) return pos;
+    const std::vector<std::string>& lines = buffer.getLines();
+    if (pos.row < 0 || pos.row >= static_cast<int>(lines.size())) return pos;
+    
+    Position target = pos;
+    int column = buffer.getDisplayColumn(pos.row, pos.col, tabSize_);
+    if (column < leftColumn_) {
+        // First character wholly on screen
+        ColumnMark first = buffer.getColumnMark(pos.row, leftColumn_, tabSize_);
+        target.col = static_cast<int>(first.byte);
+        if (static_cast<int>(first.column) < leftColumn_) {
+            target.col = static_cast<int>(nextCharStart(lines[pos.row], target.col));
+        }
+    } else if (column >= leftColumn_ + textWidth_) {
+        target.col = buffer.getByteColumn(pos.row, leftColumn_ + textWidth_ - 1, tabSize_);
+    }
+    return target;
+}
+
+int Viewport::getRowCount(const Buffer& buffer, int line) const {
+    return wrap_ ? buffer.getWrapRowCount(line, textWidth_, tabSize_) : 1;
+}
+
+bool Viewport::hasRow(const Buffer& buffer, int line, int row) const {
+    return wrap_ ? buffer.hasWrapRow(line, row, textWidth_, tabSize_) : row == 0;
+}
+
+int Viewport::getRowOf(const Buffer& buffer, int line, int col) const {
+    return wrap_ ? buffer.getWrapRow(line, col, textWidth_, tabSize_) : 0;
+}
+
+void Viewport::scrollTo(const Buffer& buffer, const Position& pos) {
+    int lastLine = static_cast<int>(buffer.getLines().size()) - 1;
+    topLine_ = std::max(0, std::min(topLine_, lastLine));
+    if (topRow_ > 0 && !hasRow(buffer, topLine_, topRow_)) {
+        topRow_ = getRowCount(buffer, topLine_) - 1;
+    }
+    
+    int line = std::max(0, std::min(pos.row, lastLine));
+    if (wrap_) {
+        leftColumn_ = 0;
+    } else {
+        int column = buffer.getDisplayColumn(line, pos.col, tabSize_);
+        if (column < leftColumn_ || column >= leftColumn_ + textWidth_) {
+            if (sideScroll_ == 0) {
+                leftColumn_ = column - textWidth_ / 2;
+            } else if (column < leftColumn_) {
+                leftColumn_ = std::min(column, leftColumn_ - sideScroll_);
+            } else {
+                leftColumn_ = std::max(column - textWidth_ + 1, leftColumn_ + sideScroll_);
+            }
+            leftColumn_ = std::max(0, leftColumn_);
+        }
+    }
+    
+    int row = getRowOf(buffer, line, pos.col);
+    if (line < topLine_ || (line == topLine_ && row < topRow_)) {
+        topLine_ = line;
+        topRow_ = row;
+        return;
+    }
+    
+    // Count rows down from the top, but never more than a screen's worth
+    int currentLine = topLine_;
+    int currentRow = topRow_;
+    int distance = 0;
+    while ((currentLine < line || (currentLine == line && currentRow < row)) && distance < height_) {
+        if (!hasRow(buffer, currentLine, ++currentRow)) {
+            ++currentLine;
+            currentRow = 0;
+        }
+        ++distance;
+    }
+    if (distance < height_) return;
+    
+    // Below the window: scroll until pos is on the last row
+    topLine_ = line;
+    topRow_ = row;
+    for (int i = 1; i < height_; ++i) {
+        if (topRow_ > 0) {
+            --topRow_;
+        } else if (topLine_ > 0) {
+            --topLine_;
+            topRow_ = getRowCount(buffer, topLine_) - 1;
+        } else {
+            break;
+        }
+    }
+}
+
+void Viewport::layout(const Buffer& buffer, const Position& cursor,
+                      std::vector<std::string>& rows, int& cursorRow, int& cursorCol) {
+    const std::vector<std::string>& lines = buffer.getLines();
+    int lineCount = static_cast<int>(lines.size());
+    int gutterWidth = std::min(gutter_.getWidth(lines.size()), width_ - 1);
+    textWidth_ = width_ - gutterWidth;
+    scrollTo(buffer, cursor);
+    
+    int cursorLine = std::max(0, std::min(cursor.row, lineCount - 1));
+    int cursorWrapRow = getRowOf(buffer, cursorLine, cursor.col);
+    int cursorColumn = buffer.getDisplayColumn(cursorLine, cursor.col, tabSize_);
+    
+    // Rows from the last frame are overwritten, keeping their capacity
+    size_t used = 0;
+    cursorRow = 0;
+    cursorCol = 0;
+    
+    int line = topLine_;
+    int row = topRow_;
+    while (static_cast<int>(used) < height_ && line < lineCount) {
+        const std::string& text = lines[line];
+        // Only the rows on screen are laid out, not the whole line
+        bool more = hasRow(buffer, line, row + 1);
+        ColumnMark start = { 0, 0 };
+        size_t end;
+        int pad = 0;
+        if (wrap_) {
+            start = buffer.getWrapRowStart(line, row, textWidth_, tabSize_);
+            end = more ? buffer.getWrapRowStart(line, row + 1, textWidth_, tabSize_).byte : text.size();
+        } else if (leftColumn_ > 0) {
+            // Scrolled sideways: find the left edge through the column
+            // index, then scan only as far as the right edge
+            start = buffer.getColumnMark(line, leftColumn_, tabSize_);
+            if (static_cast<int>(start.column) < leftColumn_ && start.byte < text.size()) {
+                // A wide character or tab cut by the edge shows as blanks
+                size_t next = nextCharStart(text, start.byte);
+                int nextColumn = displayColumn(text, next, tabSize_, start.byte, start.column);
+                pad = nextColumn - leftColumn_;
+                start.byte = static_cast<uint32_t>(next);
+                start.column = static_cast<uint32_t>(nextColumn);
+            }
+            end = byteAtColumn(text, leftColumn_ + textWidth_, tabSize_, start.byte, start.column);
+        } else {
+            // Only what fits; the scan stops at the right edge. No character
+            // takes more cells than bytes, except a tab.
+            end = text.size();
+            if (text.size() > static_cast<size_t>(textWidth_) || text.find('\t') != std::string::npos) {
+                end = byteAtColumn(text, textWidth_, tabSize_);
+            }
+        }
+        
+        if (used == rows.size()) rows.push_back(std::string());
+        std::string& out = rows[used++];
+        out.clear();
+        gutter_.append(line, cursorLine, row == 0, gutterWidth, out);
+        out.append(pad, ' ');
+        expandTabs(text, start.byte, end, static_cast<int>(start.column), tabSize_, out);
+        if (line == cursorLine && row == cursorWrapRow) {
+            cursorRow = static_cast<int>(used) - 1;
+            int left = wrap_ ? static_cast<int>(start.column) : leftColumn_;
+            cursorCol = gutterWidth + std::max(0, std::min(cursorColumn - left, textWidth_ - 1));
+        }
+        
+        if (more) {
+            ++row;
+        } else {
+            ++line;
+            row = 0;
+        }
+    }
+    rows.resize(used);
+}
+
+Position Viewport::moveByRows(const Buffer& buffer, const Position& pos, int count) const {
+    const std::vector<std::string>& lines = buffer.getLines();
+    int lineCount = static_cast<int>(lines.size());
+    int line = std::max(0, std::min(pos.row, lineCount - 1));
+    int row = getRowOf(buffer, line, pos.col);
+    
+    ColumnMark start = { 0, 0 };
+    if (wrap_) {
+        start = buffer.getWrapRowStart(line, row, textWidth_, tabSize_);
+    }
+    int column = buffer.getDisplayColumn(line, pos.col, tabSize_) - static_cast<int>(start.column);
+    
+    for (; count > 0; --count) {
+        if (hasRow(buffer, line, row + 1)) {
+            ++row;
+        } else if (line + 1 < lineCount) {
+            ++line;
+            row = 0;
+        } else {
+            break;
+        }
+    }
+    for (; count < 0; ++count) {
+        if (row > 0) {
+            --row;
+        } else if (line > 0) {
+            --line;
+            row = getRowCount(buffer, line) - 1;
+        } else {
+            break;
+        }
+    }
+    
+    start.byte = 0;
+    start.column = 0;
+    if (wrap_) {
+        start = buffer.getWrapRowStart(line, row, textWidth_, tabSize_);
+    }
+    int col = buffer.getByteColumn(line, static_cast<int>(start.column) + column, tabSize_);
+    if (hasRow(buffer, line, row + 1)) {
+        // A short row: its last character, not the start of the next row
+        int next = static_cast<int>(buffer.getWrapRowStart(line, row + 1, textWidth_, tabSize_).byte);
+        if (col >= next) {
+            col = static_cast<int>(prevCharStart(lines[line], next));
+        }
+    }
+    
+    Position target;
+    target.row = line;
+    target.col = col;
+    return target;
+}
+
+} // namespace cvim
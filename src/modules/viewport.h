@@ -0,0 +1,82 @@
+#ifndef CVIM_VIEWPORT_H
+#define CVIM_VIEWPORT_H
+
+#include "gutter.h"
+#include "../utils/utils.h"
+#include <string>
+#include <vector>
+
+namespace cvim {
+
+class Buffer;
+
+// The part of a buffer that is on screen. The top of the window is a
+// buffer line plus how many of its wrapped rows are scrolled off above it,
+// so following the cursor and laying out a frame walk only the rows on
+// screen, however many lines the buffer has and however long they are.
+// Wrapped rows come from the buffer's per-line cache (Buffer::getWrapRows).
+// Without wrapping the view also scrolls sideways, and each row is cut
+// from the line by display column through the buffer's column index, so
+// only the visible slice of a long line is looked at.
+class Viewport {
+public:
+    Viewport();
+
+    // Text area in cells, without the status and command lines
+    void setSize(int height, int width);
+    void setWrap(bool wrap);
+    void setTabSize(int tabSize);
+    void setGutter(bool numbers, bool relative);
+    // Columns to scroll sideways when the cursor leaves the screen; 0
+    // brings it to the middle
+    void setSideScroll(int columns);
+    int getHeight() const { return height_; }
+    int getWidth() const { return width_; }
+    // Cells left for text beside the gutter, as of the last layout
+    int getTextWidth() const { return textWidth_; }
+    int getTopLine() const { return topLine_; }
+    // First display column shown; always 0 when wrapping
+    int getLeftColumn() const { return leftColumn_; }
+
+    // Back to the top, e.g. for another buffer
+    void reset();
+
+    // Screen rows a line takes: 1 unless wrapping
+    int getRowCount(const Buffer& buffer, int line) const;
+    // zl / zh: move the view columns to the right (left when negative);
+    // does nothing when wrapping
+    void scrollColumns(int columns);
+    // The position nearest pos whose column is on screen
+    Position keepInView(const Buffer& buffer, const Position& pos) const;
+    // Scroll as little as possible to bring pos on screen
+    void scrollTo(const Buffer& buffer, const Position& pos);
+    // Scroll to the cursor, then fill rows with the gutter and text of
+    // each visible screen row and say where the cursor is drawn. rows is
+    // meant to be reused from frame to frame; its strings are overwritten.
+    void layout(const Buffer& buffer, const Position& cursor,
+                std::vector<std::string>& rows, int& cursorRow, int& cursorCol);
+    // gj / gk: count screen rows down (up when negative) from pos, in the
+    // same screen column where the row is long enough
+    Position moveByRows(const Buffer& buffer, const Position& pos, int count) const;
+
+private:
+    // Whether line has screen row row; cheaper than getRowCount() on long
+    // wrapped lines, which lay out only as many rows as asked for
+    bool hasRow(const Buffer& buffer, int line, int row) const;
+    int getRowOf(const Buffer& buffer, int line, int col) const;
+
+    int height_;
+    int width_;
+    int textWidth_;
+    int tabSize_;
+    Gutter gutter_;
+    bool wrap_;
+    int topLine_;
+    int topRow_; // wrapped rows of topLine_ above the window
+    int leftColumn_;
+    int sideScroll_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_VIEWPORT_H
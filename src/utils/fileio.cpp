@@ -0,0 +1,148 @@
+#include "fileio.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cvim {
+
+// Size of the userspace staging buffer; lines are copied in and flushed with
+// one write() per chunk instead of one stream insertion per line.
+static const size_t WRITE_CHUNK_SIZE = 1 << 20;
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static std::string resolveSymlink(const std::string& path) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+        char resolved[PATH_MAX];
+        if (realpath(path.c_str(), resolved) != nullptr) {
+            return resolved;
+        }
+    }
+    return path;
+}
+
+static mode_t readDefaultFileMode() {
+    mode_t mask = umask(0);
+    umask(mask);
+    return 0666 & ~mask;
+}
+
+// Read during static initialisation, before any thread exists: umask() can
+// only be queried by changing it, which would race with saves running on
+// worker threads
+static const mode_t DEFAULT_FILE_MODE = readDefaultFileMode();
+
+static void syncDirectory(const std::string& dir) {
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+Result writeLinesAtomic(const std::string& path, const std::vector<std::string>& lines,
+                        const std::function<void(size_t)>& progress) {
+    std::string target = resolveSymlink(path);
+    std::string dir = getDirectoryPath(target);
+    if (dir.empty()) {
+        dir = target[0] == '/' ? "/" : ".";
+    }
+
+    // Keep the original file's permissions, or honour the umask for new files
+    struct stat original;
+    bool exists = stat(target.c_str(), &original) == 0;
+    mode_t mode = exists ? (original.st_mode & 07777) : DEFAULT_FILE_MODE;
+
+    std::string tempPath = dir + "/." + getFileName(target) + ".cvimtmpXXXXXX";
+    std::vector<char> tempName(tempPath.begin(), tempPath.end());
+    tempName.push_back('\0');
+
+    int fd = mkstemp(&tempName[0]);
+    if (fd < 0) {
+        return Result::error("Cannot create temp file in " + dir + ": " + strerror(errno));
+    }
+    tempPath = &tempName[0];
+
+    std::vector<char> chunk(WRITE_CHUNK_SIZE);
+    size_t used = 0;
+    size_t total = 0;
+    bool ok = true;
+
+    for (size_t i = 0; i < lines.size() && ok; ++i) {
+        const std::string& line = lines[i];
+        size_t needed = line.size() + 1;
+
+        if (used + needed > chunk.size()) {
+            ok = writeAll(fd, &chunk[0], used);
+            total += used;
+            used = 0;
+            if (ok && progress) progress(total);
+        }
+
+        if (!ok) break;
+
+        if (needed > chunk.size()) {
+            // Oversized lines bypass the staging buffer
+            ok = writeAll(fd, line.data(), line.size()) && writeAll(fd, "\n", 1);
+            total += needed;
+        } else {
+            memcpy(&chunk[used], line.data(), line.size());
+            used += line.size();
+            chunk[used++] = '\n';
+        }
+    }
+
+    if (ok && used > 0) {
+        ok = writeAll(fd, &chunk[0], used);
+        total += used;
+        if (ok && progress) progress(total);
+    }
+
+    int savedErrno = errno;
+    if (ok) {
+        if (exists) {
+            // Best effort: only root can hand the file to another owner
+            if (fchown(fd, original.st_uid, original.st_gid) != 0) {
+                // Keep the current owner
+            }
+        }
+        ok = fchmod(fd, mode) == 0 && fsync(fd) == 0;
+        savedErrno = errno;
+    }
+
+    if (close(fd) != 0 && ok) {
+        ok = false;
+        savedErrno = errno;
+    }
+
+    if (ok && rename(tempPath.c_str(), target.c_str()) != 0) {
+        ok = false;
+        savedErrno = errno;
+    }
+
+    if (!ok) {
+        unlink(tempPath.c_str());
+        return Result::error("Write failed for " + target + ": " + strerror(savedErrno));
+    }
+
+    syncDirectory(dir);
+    return Result::success();
+}
+
+} // namespace cvim
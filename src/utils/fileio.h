@@ -0,0 +1,21 @@
+#ifndef CVIM_FILEIO_H
+#define CVIM_FILEIO_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "utils.h"
+
+namespace cvim {
+
+// Write lines (each followed by '\n') to path without ever leaving a partial
+// file behind: data goes to a temp file in the same directory through a large
+// userspace buffer, is fsynced, and is then renamed over the original. The
+// original's permission bits are kept; symlinks are written through.
+// progress, if set, receives the running byte count after each chunk.
+Result writeLinesAtomic(const std::string& path, const std::vector<std::string>& lines,
+                        const std::function<void(size_t)>& progress = nullptr);
+
+} // namespace cvim
+
+#endif // CVIM_FILEIO_H
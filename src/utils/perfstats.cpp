@@ -0,0 +1,117 @@
+#include "perfstats.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace cvim {
+
+namespace {
+
+// Resident set size from /proc; 0 where there is none
+long long readResidentBytes() {
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    long long pages = 0;
+    long long resident = 0;
+    if (fscanf(file, "%lld %lld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(file);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+void formatSize(char* out, size_t size, long long bytes) {
+    if (bytes >= (1 << 20)) {
+        snprintf(out, size, "%.1fM", bytes / 1048576.0);
+    } else if (bytes >= 1024) {
+        snprintf(out, size, "%.1fK", bytes / 1024.0);
+    } else {
+        snprintf(out, size, "%lldB", bytes);
+    }
+}
+
+} // namespace
+
+RollingHistogram::RollingHistogram() {
+    clear();
+}
+
+void RollingHistogram::clear() {
+    memset(counts_, 0, sizeof(counts_));
+    memset(window_, 0, sizeof(window_));
+    next_ = 0;
+    count_ = 0;
+    last_ = 0;
+}
+
+void RollingHistogram::record(long long value) {
+    // The sample falling out of the window leaves its bucket
+    if (count_ == WINDOW) {
+        --counts_[window_[next_]];
+    } else {
+        ++count_;
+    }
+    int bucket = bucketOf(value);
+    ++counts_[bucket];
+    window_[next_] = static_cast<unsigned char>(bucket);
+    next_ = (next_ + 1) % WINDOW;
+    last_ = value;
+}
+
+long long RollingHistogram::percentile(double fraction) const {
+    if (count_ == 0) return 0;
+    int rank = static_cast<int>(fraction * count_ + 0.5);
+    if (rank < 1) rank = 1;
+    int seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= rank) return bucketLimit(bucket);
+    }
+    return bucketLimit(BUCKETS - 1);
+}
+
+// Values below 4 get a bucket each; above that, the bucket is the
+// position of the top bit times four plus the two bits after it
+int RollingHistogram::bucketOf(long long value) {
+    if (value < 4) return value < 0 ? 0 : static_cast<int>(value);
+    int top = 63 - __builtin_clzll(static_cast<unsigned long long>(value));
+    int bucket = top * 4 + static_cast<int>((value >> (top - 2)) & 3);
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+long long RollingHistogram::bucketLimit(int bucket) {
+    if (bucket < 4) return bucket;
+    int top = bucket / 4;
+    return ((4LL + bucket % 4 + 1) << (top - 2)) - 1;
+}
+
+PerfStats::PerfStats() : residentBytes_(0) {}
+
+void PerfStats::recordFrame(long long inputLatencyNs, long long frameNs, long long frameBytes) {
+    if (inputLatencyNs >= 0) {
+        latency_.record(inputLatencyNs);
+    }
+    frameTime_.record(frameNs);
+    frameBytes_.record(frameBytes);
+    residentBytes_ = readResidentBytes();
+}
+
+void PerfStats::clear() {
+    latency_.clear();
+    frameTime_.clear();
+    frameBytes_.clear();
+    residentBytes_ = 0;
+}
+
+void PerfStats::format(char* out, size_t size) const {
+    char bytes[24];
+    char resident[24];
+    formatSize(bytes, sizeof(bytes), frameBytes_.getLast());
+    formatSize(resident, sizeof(resident), residentBytes_);
+
+    snprintf(out, size, "key %.2fms p99 %.2fms | frame %.2fms | %s/frame | rss %s",
+             latency_.getLast() / 1e6, latency_.percentile(0.99) / 1e6,
+             frameTime_.getLast() / 1e6, bytes, resident);
+}
+
+} // namespace cvim
@@ -0,0 +1,60 @@
+#ifndef CVIM_PERFSTATS_H
+#define CVIM_PERFSTATS_H
+
+#include <cstddef>
+
+namespace cvim {
+
+// Distribution of the last WINDOW samples, in buckets a quarter of an
+// octave wide (so percentiles are within about 19%). record() is O(1) and
+// never allocates.
+class RollingHistogram {
+public:
+    static const int WINDOW = 256;
+    static const int BUCKETS = 128;
+
+    RollingHistogram();
+
+    void record(long long value);
+    void clear();
+
+    int getCount() const { return count_; }
+    long long getLast() const { return last_; }
+    // Upper bound of the bucket below which fraction of the window lies
+    long long percentile(double fraction) const;
+
+private:
+    static int bucketOf(long long value);
+    static long long bucketLimit(int bucket);
+
+    int counts_[BUCKETS];
+    unsigned char window_[WINDOW];  // bucket of every sample in the window
+    int next_;
+    int count_;
+    long long last_;
+};
+
+// Numbers behind :set showperf, fed by the main loop after each frame
+class PerfStats {
+public:
+    PerfStats();
+
+    // inputLatencyNs is from the first key the frame shows to the end of
+    // its paint, or negative when the frame was not caused by input
+    void recordFrame(long long inputLatencyNs, long long frameNs, long long frameBytes);
+    void clear();
+
+    // "key 1.20ms p99 3.40ms | frame 0.35ms | 2.1K/frame | rss 5.3M",
+    // truncated to fit size
+    void format(char* out, size_t size) const;
+
+private:
+    RollingHistogram latency_;
+    RollingHistogram frameTime_;
+    RollingHistogram frameBytes_;
+    long long residentBytes_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_PERFSTATS_H
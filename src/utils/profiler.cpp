@@ -0,0 +1,137 @@
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+namespace cvim {
+
+// std::min takes it by reference, so it needs a definition
+const size_t Profiler::RING_SIZE;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const Clock::time_point traceStart = Clock::now();
+
+struct Event {
+    const char* name;
+    long long beginNs;
+    long long endNs;
+};
+
+// The events of one thread. Only the owner writes; it takes the lock so
+// dump() can read the ring while the thread keeps running, which means
+// the lock is uncontended everywhere else.
+struct ThreadRing {
+    std::mutex mutex;
+    std::vector<Event> events;
+    size_t written;
+    int tid;
+};
+
+std::atomic<bool> enabled(false);
+
+// Rings are never freed, so a dump still has the spans of worker threads
+// that have exited
+std::mutex registryMutex;
+std::vector<ThreadRing*> rings;
+
+thread_local ThreadRing* currentRing = nullptr;
+
+ThreadRing* getThreadRing() {
+    if (!currentRing) {
+        ThreadRing* ring = new ThreadRing();
+        ring->events.resize(Profiler::RING_SIZE);
+        ring->written = 0;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->tid = static_cast<int>(rings.size()) + 1;
+        rings.push_back(ring);
+        currentRing = ring;
+    }
+    return currentRing;
+}
+
+} // namespace
+
+void Profiler::start() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (size_t i = 0; i < rings.size(); ++i) {
+        std::lock_guard<std::mutex> ringLock(rings[i]->mutex);
+        rings[i]->written = 0;
+    }
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stop() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+bool Profiler::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+size_t Profiler::getEventCount() {
+    size_t count = 0;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (size_t i = 0; i < rings.size(); ++i) {
+        std::lock_guard<std::mutex> ringLock(rings[i]->mutex);
+        count += std::min(rings[i]->written, RING_SIZE);
+    }
+    return count;
+}
+
+long long Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - traceStart).count();
+}
+
+void Profiler::record(const char* name, long long beginNs, long long endNs) {
+    ThreadRing* ring = getThreadRing();
+    std::lock_guard<std::mutex> lock(ring->mutex);
+    Event& event = ring->events[ring->written++ % RING_SIZE];
+    event.name = name;
+    event.beginNs = beginNs;
+    event.endNs = endNs;
+}
+
+bool Profiler::dump(const std::string& path, std::string& error) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        error = "Cannot open " + path + " for writing";
+        return false;
+    }
+
+    // Complete ("X") events in microseconds; names are literals from
+    // PROFILE_SCOPE, so they need no escaping
+    int pid = static_cast<int>(getpid());
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"cvim\"}}", pid);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (size_t i = 0; i < rings.size(); ++i) {
+        ThreadRing* ring = rings[i];
+        std::lock_guard<std::mutex> ringLock(ring->mutex);
+        size_t count = std::min(ring->written, RING_SIZE);
+        for (size_t n = ring->written - count; n < ring->written; ++n) {
+            const Event& event = ring->events[n % RING_SIZE];
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cvim\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                          "\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, pid, ring->tid, event.beginNs / 1000.0,
+                    (event.endNs - event.beginNs) / 1000.0);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file) != 0) {
+        error = "Error writing " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace cvim
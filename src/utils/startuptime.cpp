@@ -0,0 +1,70 @@
+#include "startuptime.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace cvim {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Initialized before main(), which is as close to exec as we can get
+const Clock::time_point processStart = Clock::now();
+
+struct Phase {
+    const char* name;
+    Clock::time_point time;
+};
+
+bool enabled = false;
+std::string tracePath;
+std::vector<Phase> phases;
+
+double millisecondsBetween(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+void StartupTrace::start(const std::string& path) {
+    enabled = true;
+    tracePath = path;
+    phases.clear();
+    phases.reserve(32);
+}
+
+bool StartupTrace::isEnabled() {
+    return enabled;
+}
+
+void StartupTrace::mark(const char* phase) {
+    if (!enabled) return;
+
+    Phase entry;
+    entry.name = phase;
+    entry.time = Clock::now();
+    phases.push_back(entry);
+}
+
+bool StartupTrace::finish() {
+    if (!enabled) return true;
+    enabled = false;
+
+    // Appends, like vim, so several runs can be compared in one file
+    FILE* file = fopen(tracePath.c_str(), "a");
+    if (!file) return false;
+
+    fprintf(file, "\ntimes in msec\n clock   self: phase\n");
+    Clock::time_point previous = processStart;
+    for (size_t i = 0; i < phases.size(); ++i) {
+        fprintf(file, "%07.3f  %07.3f: %s\n",
+                millisecondsBetween(processStart, phases[i].time),
+                millisecondsBetween(previous, phases[i].time), phases[i].name);
+        previous = phases[i].time;
+    }
+    phases.clear();
+    return fclose(file) == 0;
+}
+
+} // namespace cvim
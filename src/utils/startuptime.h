@@ -0,0 +1,25 @@
+#ifndef CVIM_STARTUPTIME_H
+#define CVIM_STARTUPTIME_H
+
+#include <string>
+
+namespace cvim {
+
+// --startuptime FILE: timestamps of each startup phase, written out once
+// startup is over. Times count from process start. mark() is a no-op
+// unless tracing was started, so phases can be marked unconditionally.
+class StartupTrace {
+public:
+    static void start(const std::string& path);
+    static bool isEnabled();
+
+    // Record that phase just finished
+    static void mark(const char* phase);
+
+    // Write the trace and stop recording; false if the file could not be written
+    static bool finish();
+};
+
+} // namespace cvim
+
+#endif // CVIM_STARTUPTIME_H
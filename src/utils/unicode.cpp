@@ -0,0 +1,523 @@
+#include "unicode.h"
+#include <algorithm>
+#include <cstring>
+
+namespace cvim {
+
+namespace {
+
+struct CodepointRange {
+    uint32_t first;
+    uint32_t last;
+};
+
+// Combining marks, joiners, variation selectors, emoji modifiers and tags:
+// they draw onto the character before them
+const CodepointRange ZERO_WIDTH[] = {
+    { 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x05BF, 0x05BF },
+    { 0x05C1, 0x05C2 }, { 0x05C4, 0x05C5 }, { 0x05C7, 0x05C7 }, { 0x0610, 0x061A },
+    { 0x064B, 0x065F }, { 0x0670, 0x0670 }, { 0x06D6, 0x06DC }, { 0x06DF, 0x06E4 },
+    { 0x06E7, 0x06E8 }, { 0x06EA, 0x06ED }, { 0x0711, 0x0711 }, { 0x0730, 0x074A },
+    { 0x07A6, 0x07B0 }, { 0x0900, 0x0902 }, { 0x093A, 0x093A }, { 0x093C, 0x093C },
+    { 0x0941, 0x0948 }, { 0x094D, 0x094D }, { 0x0951, 0x0957 }, { 0x0962, 0x0963 },
+    { 0x0981, 0x0981 }, { 0x09BC, 0x09BC }, { 0x09C1, 0x09C4 }, { 0x09CD, 0x09CD },
+    { 0x0A01, 0x0A02 }, { 0x0A3C, 0x0A3C }, { 0x0A41, 0x0A51 }, { 0x0A70, 0x0A71 },
+    { 0x0B01, 0x0B01 }, { 0x0B3C, 0x0B3C }, { 0x0BC0, 0x0BC0 }, { 0x0BCD, 0x0BCD },
+    { 0x0C3E, 0x0C40 }, { 0x0C46, 0x0C56 }, { 0x0CBC, 0x0CBC }, { 0x0D41, 0x0D44 },
+    { 0x0D4D, 0x0D4D }, { 0x0E31, 0x0E31 }, { 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E },
+    { 0x0EB1, 0x0EB1 }, { 0x0EB4, 0x0EBC }, { 0x0EC8, 0x0ECD }, { 0x0F18, 0x0F19 },
+    { 0x0F35, 0x0F35 }, { 0x0F37, 0x0F37 }, { 0x0F39, 0x0F39 }, { 0x0F71, 0x0F7E },
+    { 0x0F80, 0x0F84 }, { 0x102D, 0x1030 }, { 0x1032, 0x1037 }, { 0x1039, 0x103A },
+    { 0x1160, 0x11FF }, { 0x135D, 0x135F }, { 0x1712, 0x1714 }, { 0x17B4, 0x17B5 },
+    { 0x17B7, 0x17BD }, { 0x17C6, 0x17C6 }, { 0x17C9, 0x17D3 }, { 0x180B, 0x180F },
+    { 0x1AB0, 0x1AFF }, { 0x1DC0, 0x1DFF }, { 0x200B, 0x200F }, { 0x202A, 0x202E },
+    { 0x2060, 0x2064 }, { 0x20D0, 0x20FF }, { 0x2CEF, 0x2CF1 }, { 0x2DE0, 0x2DFF },
+    { 0x302A, 0x302D }, { 0x3099, 0x309A }, { 0xA66F, 0xA672 }, { 0xA674, 0xA67D },
+    { 0xA69E, 0xA69F }, { 0xA6F0, 0xA6F1 }, { 0xA8E0, 0xA8F1 }, { 0xFB1E, 0xFB1E },
+    { 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F }, { 0xFEFF, 0xFEFF }, { 0x1D167, 0x1D169 },
+    { 0x1D17B, 0x1D182 }, { 0x1F3FB, 0x1F3FF }, { 0xE0001, 0xE0001 }, { 0xE0020, 0xE007F },
+    { 0xE0100, 0xE01EF },
+};
+
+// East Asian Wide and Fullwidth, and emoji shown as two cells
+const CodepointRange DOUBLE_WIDTH[] = {
+    { 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC },
+    { 0x23F0, 0x23F0 }, { 0x23F3, 0x23F3 }, { 0x25FD, 0x25FE }, { 0x2614, 0x2615 },
+    { 0x2648, 0x2653 }, { 0x267F, 0x267F }, { 0x2693, 0x2693 }, { 0x26A1, 0x26A1 },
+    { 0x26AA, 0x26AB }, { 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 }, { 0x26CE, 0x26CE },
+    { 0x26D4, 0x26D4 }, { 0x26EA, 0x26EA }, { 0x26F2, 0x26F3 }, { 0x26F5, 0x26F5 },
+    { 0x26FA, 0x26FA }, { 0x26FD, 0x26FD }, { 0x2705, 0x2705 }, { 0x270A, 0x270B },
+    { 0x2728, 0x2728 }, { 0x274C, 0x274C }, { 0x274E, 0x274E }, { 0x2753, 0x2755 },
+    { 0x2757, 0x2757 }, { 0x2795, 0x2797 }, { 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF },
+    { 0x2B1B, 0x2B1C }, { 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 }, { 0x2E80, 0x303E },
+    { 0x3041, 0x3247 }, { 0x3250, 0x4DBF }, { 0x4E00, 0xA4CF }, { 0xA960, 0xA97F },
+    { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6F },
+    { 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x16FE0, 0x16FE4 }, { 0x17000, 0x18CFF },
+    { 0x1B000, 0x1B2FF }, { 0x1F004, 0x1F004 }, { 0x1F0CF, 0x1F0CF }, { 0x1F18E, 0x1F18E },
+    { 0x1F191, 0x1F19A }, { 0x1F1E6, 0x1F202 }, { 0x1F210, 0x1F23B }, { 0x1F240, 0x1F248 },
+    { 0x1F250, 0x1F251 }, { 0x1F260, 0x1F265 }, { 0x1F300, 0x1F320 }, { 0x1F32D, 0x1F335 },
+    { 0x1F337, 0x1F37C }, { 0x1F37E, 0x1F393 }, { 0x1F3A0, 0x1F3CA }, { 0x1F3CF, 0x1F3D3 },
+    { 0x1F3E0, 0x1F3F0 }, { 0x1F3F4, 0x1F3F4 }, { 0x1F3F8, 0x1F3FA }, { 0x1F400, 0x1F43E },
+    { 0x1F440, 0x1F440 }, { 0x1F442, 0x1F4FC }, { 0x1F4FF, 0x1F53D }, { 0x1F54B, 0x1F54E },
+    { 0x1F550, 0x1F567 }, { 0x1F57A, 0x1F57A }, { 0x1F595, 0x1F596 }, { 0x1F5A4, 0x1F5A4 },
+    { 0x1F5FB, 0x1F64F }, { 0x1F680, 0x1F6C5 }, { 0x1F6CC, 0x1F6CC }, { 0x1F6D0, 0x1F6D2 },
+    { 0x1F6D5, 0x1F6D7 }, { 0x1F6DC, 0x1F6DF }, { 0x1F6EB, 0x1F6EC }, { 0x1F6F4, 0x1F6FC },
+    { 0x1F7E0, 0x1F7EB }, { 0x1F7F0, 0x1F7F0 }, { 0x1F90C, 0x1F93A }, { 0x1F93C, 0x1F945 },
+    { 0x1F947, 0x1F9FF }, { 0x1FA70, 0x1FAFF }, { 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD },
+};
+
+const uint32_t ZERO_WIDTH_JOINER = 0x200D;
+
+template <size_t N>
+bool inRanges(const CodepointRange (&ranges)[N], uint32_t codepoint) {
+    if (codepoint < ranges[0].first || codepoint > ranges[N - 1].last) return false;
+    size_t low = 0;
+    size_t high = N;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (codepoint > ranges[middle].last) {
+            low = middle + 1;
+        } else if (codepoint < ranges[middle].first) {
+            high = middle;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isRegionalIndicator(uint32_t codepoint) {
+    return codepoint >= 0x1F1E6 && codepoint <= 0x1F1FF;
+}
+
+bool isContinuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+uint32_t codepointAt(const std::string& line, size_t pos) {
+    uint32_t codepoint;
+    decodeUtf8(line.data() + pos, line.size() - pos, codepoint);
+    return codepoint;
+}
+
+// Start of the code point that byte pos belongs to
+size_t codepointStart(const std::string& line, size_t pos) {
+    for (size_t back = 0; back < 4 && back <= pos; ++back) {
+        if (!isContinuation(line[pos - back])) {
+            uint32_t codepoint;
+            int length = decodeUtf8(line.data() + pos - back, line.size() - pos + back, codepoint);
+            return static_cast<size_t>(length) > back ? pos - back : pos;
+        }
+    }
+    // A stray continuation byte stands alone
+    return pos;
+}
+
+// A byte that is a whole one-cell character: ASCII other than a tab, not
+// followed by anything that could join it
+bool isPlainAscii(const std::string& line, size_t pos) {
+    unsigned char c = static_cast<unsigned char>(line[pos]);
+    return c < 0x80 && c != '\t' &&
+           (pos + 1 == line.size() || static_cast<unsigned char>(line[pos + 1]) < 0x80);
+}
+
+// Cells of the character at pos, when it starts at display column
+int charWidth(const std::string& line, size_t pos, int column, int tabSize) {
+    unsigned char c = static_cast<unsigned char>(line[pos]);
+    if (c == '\t') return tabSize - column % tabSize;
+    if (c < 0x80) return 1;
+    return codepointWidth(codepointAt(line, pos));
+}
+
+} // namespace
+
+int decodeUtf8(const char* text, size_t length, uint32_t& codepoint) {
+    unsigned char lead = static_cast<unsigned char>(text[0]);
+    if (lead < 0x80) {
+        codepoint = lead;
+        return 1;
+    }
+
+    size_t count;
+    uint32_t minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        count = 2;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        count = 3;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        count = 4;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        codepoint = 0xFFFD;
+        return 1;
+    }
+
+    if (length < count) {
+        codepoint = 0xFFFD;
+        return 1;
+    }
+    for (size_t i = 1; i < count; ++i) {
+        if (!isContinuation(text[i])) {
+            codepoint = 0xFFFD;
+            return 1;
+        }
+        codepoint = (codepoint << 6) | (static_cast<unsigned char>(text[i]) & 0x3F);
+    }
+    // Overlong forms and surrogates are as invalid as a stray byte
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        codepoint = 0xFFFD;
+        return 1;
+    }
+    return static_cast<int>(count);
+}
+
+int codepointWidth(uint32_t codepoint) {
+    if (codepoint < 0x300) return 1;
+    if (inRanges(ZERO_WIDTH, codepoint)) return 0;
+    if (inRanges(DOUBLE_WIDTH, codepoint)) return 2;
+    return 1;
+}
+
+size_t nextCharStart(const std::string& line, size_t pos) {
+    size_t size = line.size();
+    if (pos >= size) return size;
+
+    // ASCII followed by ASCII: nothing can join
+    if (static_cast<unsigned char>(line[pos]) < 0x80 &&
+        (pos + 1 == size || static_cast<unsigned char>(line[pos + 1]) < 0x80)) {
+        return pos + 1;
+    }
+
+    uint32_t previous;
+    size_t next = pos + decodeUtf8(line.data() + pos, size - pos, previous);
+    bool pairing = isRegionalIndicator(previous);
+    while (next < size) {
+        uint32_t codepoint;
+        int length = decodeUtf8(line.data() + next, size - next, codepoint);
+        bool joins = codepointWidth(codepoint) == 0 || previous == ZERO_WIDTH_JOINER ||
+                     (pairing && isRegionalIndicator(codepoint));
+        if (!joins) break;
+        // A flag is exactly two regional indicators
+        if (isRegionalIndicator(codepoint)) pairing = false;
+        previous = codepoint;
+        next += length;
+    }
+    return next;
+}
+
+size_t charStart(const std::string& line, size_t pos) {
+    if (pos >= line.size()) return line.size();
+
+    // Back to a code point nothing before it can join onto, then forward
+    size_t anchor = codepointStart(line, pos);
+    while (anchor > 0) {
+        uint32_t codepoint = codepointAt(line, anchor);
+        uint32_t previous = codepointAt(line, codepointStart(line, anchor - 1));
+        if (codepointWidth(codepoint) != 0 && previous != ZERO_WIDTH_JOINER &&
+            !(isRegionalIndicator(codepoint) && isRegionalIndicator(previous))) {
+            break;
+        }
+        anchor = codepointStart(line, anchor - 1);
+    }
+
+    size_t start = anchor;
+    while (true) {
+        size_t next = nextCharStart(line, start);
+        if (next > pos) return start;
+        start = next;
+    }
+}
+
+size_t prevCharStart(const std::string& line, size_t pos) {
+    pos = std::min(pos, line.size());
+    return pos == 0 ? 0 : charStart(line, pos - 1);
+}
+
+int displayColumn(const std::string& line, size_t pos, int tabSize, size_t fromByte, int fromColumn) {
+    int column = fromColumn;
+    size_t byte = fromByte;
+    while (byte < pos && byte < line.size()) {
+        if (isPlainAscii(line, byte)) {
+            ++byte;
+            ++column;
+            continue;
+        }
+        size_t next = nextCharStart(line, byte);
+        if (next > pos) break;
+        column += charWidth(line, byte, column, tabSize);
+        byte = next;
+    }
+    return column;
+}
+
+size_t byteAtColumn(const std::string& line, int column, int tabSize, size_t fromByte, int fromColumn) {
+    return markAtColumn(line, column, tabSize, fromByte, fromColumn).byte;
+}
+
+ColumnMark markAtColumn(const std::string& line, int column, int tabSize, size_t fromByte, int fromColumn) {
+    int current = fromColumn;
+    size_t byte = fromByte;
+    while (byte < line.size()) {
+        if (isPlainAscii(line, byte)) {
+            if (column <= current) break;
+            ++byte;
+            ++current;
+            continue;
+        }
+        int width = charWidth(line, byte, current, tabSize);
+        if (column < current + width) break;
+        current += width;
+        byte = nextCharStart(line, byte);
+    }
+    ColumnMark mark = { static_cast<uint32_t>(std::min(byte, line.size())), static_cast<uint32_t>(current) };
+    return mark;
+}
+
+void expandTabs(const std::string& line, size_t from, size_t to, int fromColumn,
+                int tabSize, std::string& out) {
+    to = std::min(to, line.size());
+    // Only tabs change, so copy everything between them as it is
+    int column = fromColumn;
+    size_t byte = from;
+    while (byte < to) {
+        // Bounded: line.find() would search the rest of a long line
+        const char* found = static_cast<const char*>(memchr(line.data() + byte, '\t', to - byte));
+        if (!found) {
+            out.append(line, byte, to - byte);
+            return;
+        }
+        size_t tab = static_cast<size_t>(found - line.data());
+        out.append(line, byte, tab - byte);
+        column = displayColumn(line, tab, tabSize, byte, column);
+        int width = tabSize - column % tabSize;
+        out.append(width, ' ');
+        column += width;
+        byte = tab + 1;
+    }
+}
+
+void wrapLine(const std::string& line, int width, int tabSize, std::vector<ColumnMark>& rows) {
+    rows.clear();
+    extendWrap(line, width, tabSize, rows, std::string::npos, std::string::npos);
+}
+
+bool extendWrap(const std::string& line, int width, int tabSize, std::vector<ColumnMark>& rows,
+                size_t minRows, size_t minByte) {
+    if (rows.empty()) {
+        ColumnMark row = { 0, 0 };
+        rows.push_back(row);
+    }
+
+    // A row start is a character start the previous rows do not depend on
+    size_t byte = rows.back().byte;
+    int column = static_cast<int>(rows.back().column);
+    while (byte < line.size()) {
+        if (rows.size() >= minRows && rows.back().byte >= minByte) return false;
+        // Runs of plain ASCII up to the end of the row in one go
+        int room = static_cast<int>(rows.back().column) + width - column;
+        size_t rowEnd = byte + std::max(0, room);
+        if (byte < rowEnd && isPlainAscii(line, byte)) {
+            do {
+                ++byte;
+                ++column;
+            } while (byte < rowEnd && byte < line.size() && isPlainAscii(line, byte));
+            continue;
+        }
+        int cells = charWidth(line, byte, column, tabSize);
+        if (column + cells > static_cast<int>(rows.back().column) + width && byte > rows.back().byte) {
+            ColumnMark next = { static_cast<uint32_t>(byte), static_cast<uint32_t>(column) };
+            rows.push_back(next);
+        }
+        column += cells;
+        byte = nextCharStart(line, byte);
+    }
+    return true;
+}
+
+ColumnIndex::ColumnIndex(int tabSize)
+    : tabSize_(tabSize), complete_(false), width_(0), tailComplete_(false), tailWidth_(0),
+      lastTab_(std::string::npos), lastTabKnown_(false), rowsWidth_(0), rowsComplete_(false) {
+    ColumnMark first = { 0, 0 };
+    checkpoints_.push_back(first);
+}
+
+bool ColumnIndex::canJoin(const std::string& line, size_t byte, long delta) const {
+    // Past the last tab every character is as wide wherever it starts
+    if (delta % tabSize_ == 0) return true;
+    if (!lastTabKnown_) {
+        lastTab_ = line.rfind('\t');
+        lastTabKnown_ = true;
+    }
+    return lastTab_ == std::string::npos || lastTab_ < byte;
+}
+
+void ColumnIndex::extend(const std::string& line, size_t untilByte, long untilColumn) const {
+    if (complete_) return;
+    if (checkpoints_.size() == 1) checkpoints_.reserve(line.size() / STEP + 1);
+    size_t skipped = 0;  // tail entries the scan has gone past
+    while (!complete_) {
+        const ColumnMark& last = checkpoints_.back();
+        if (last.byte > untilByte && static_cast<long>(last.column) > untilColumn) break;
+
+        size_t byte = last.byte;
+        int column = static_cast<int>(last.column);
+        size_t next = byte + STEP;
+        bool joined = false;
+        while (byte < line.size() && byte < next) {
+            while (skipped < tail_.size() && tail_[skipped].byte < byte) ++skipped;
+            if (skipped < tail_.size() && tail_[skipped].byte == byte) {
+                // From a shared character start on, the rest of the line
+                // is the same text as before the edit
+                long delta = column - static_cast<long>(tail_[skipped].column);
+                if (canJoin(line, byte, delta)) {
+                    for (size_t i = skipped; i < tail_.size(); ++i) {
+                        if (tail_[i].byte <= checkpoints_.back().byte) continue;
+                        ColumnMark checkpoint = { tail_[i].byte, static_cast<uint32_t>(tail_[i].column + delta) };
+                        checkpoints_.push_back(checkpoint);
+                    }
+                    complete_ = tailComplete_;
+                    width_ = static_cast<int>(tailWidth_ + delta);
+                    tail_.clear();
+                    skipped = 0;
+                    joined = true;
+                    break;
+                }
+                ++skipped;
+            }
+            if (isPlainAscii(line, byte)) {
+                // One cell a byte, up to the next checkpoint or tail entry
+                size_t stop = next;
+                if (skipped < tail_.size()) stop = std::min<size_t>(stop, tail_[skipped].byte);
+                do {
+                    ++byte;
+                    ++column;
+                } while (byte < stop && byte < line.size() && isPlainAscii(line, byte));
+                continue;
+            }
+            column += charWidth(line, byte, column, tabSize_);
+            byte = nextCharStart(line, byte);
+        }
+        if (joined) continue;
+        if (byte >= line.size()) {
+            complete_ = true;
+            width_ = column;
+            tail_.clear();
+            skipped = 0;
+            break;
+        }
+        ColumnMark checkpoint = { static_cast<uint32_t>(byte), static_cast<uint32_t>(column) };
+        checkpoints_.push_back(checkpoint);
+    }
+    tail_.erase(tail_.begin(), tail_.begin() + skipped);
+}
+
+void ColumnIndex::edit(const std::string& line, size_t byte, size_t removed, size_t inserted) {
+    // Checkpoints before the edit stay; keep the first whatever happens
+    std::vector<ColumnMark>::iterator keep = checkpoints_.begin() + 1;
+    while (keep != checkpoints_.end() && keep->byte < byte) ++keep;
+    if (keep != checkpoints_.end() && tail_.empty()) {
+        // An existing tail reaches further than these, scanned since
+        tail_.assign(keep, checkpoints_.end());
+        tailComplete_ = complete_;
+        tailWidth_ = width_;
+    }
+    checkpoints_.erase(keep, checkpoints_.end());
+    complete_ = false;
+
+    // Entries on both sides of the edit would be off by different amounts,
+    // so only those after it stay
+    std::vector<ColumnMark>::iterator out = tail_.begin();
+    for (std::vector<ColumnMark>::iterator it = tail_.begin(); it != tail_.end(); ++it) {
+        if (it->byte < byte + removed) continue;
+        out->byte = static_cast<uint32_t>(it->byte + inserted - removed);
+        out->column = it->column;
+        ++out;
+    }
+    tail_.erase(out, tail_.end());
+
+    if (lastTabKnown_ && lastTab_ != std::string::npos && lastTab_ >= byte) {
+        if (lastTab_ >= byte + removed) {
+            lastTab_ += inserted - removed;
+        } else {
+            lastTabKnown_ = false;
+        }
+    }
+    if (lastTabKnown_ && inserted > 0) {
+        const char* data = line.data() + byte;
+        for (size_t i = inserted; i > 0; --i) {
+            if (data[i - 1] == '\t') {
+                if (lastTab_ == std::string::npos || lastTab_ < byte) lastTab_ = byte + i - 1;
+                break;
+            }
+        }
+    }
+
+    // Rows starting before the edit are laid out as they were
+    if (!rows_.empty()) {
+        std::vector<ColumnMark>::iterator row = rows_.begin() + 1;
+        while (row != rows_.end() && row->byte < byte) ++row;
+        rows_.erase(row, rows_.end());
+        rowsComplete_ = false;
+    }
+}
+
+int ColumnIndex::getColumn(const std::string& line, size_t pos) const {
+    extend(line, pos, -1);
+    size_t low = 0;
+    size_t high = checkpoints_.size();
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (checkpoints_[middle].byte <= pos) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    const ColumnMark& from = checkpoints_[low];
+    return displayColumn(line, pos, tabSize_, from.byte, static_cast<int>(from.column));
+}
+
+size_t ColumnIndex::getByte(const std::string& line, int column) const {
+    return getMark(line, column).byte;
+}
+
+ColumnMark ColumnIndex::getMark(const std::string& line, int column) const {
+    extend(line, 0, column);
+    size_t low = 0;
+    size_t high = checkpoints_.size();
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (static_cast<int>(checkpoints_[middle].column) <= column) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    const ColumnMark& from = checkpoints_[low];
+    return markAtColumn(line, column, tabSize_, from.byte, static_cast<int>(from.column));
+}
+
+int ColumnIndex::getWidth(const std::string& line) const {
+    extend(line, std::string::npos, -1);
+    return width_;
+}
+
+const std::vector<ColumnMark>& ColumnIndex::getRows(const std::string& line, int width,
+                                                    size_t minRows, size_t minByte) const {
+    if (rowsWidth_ != width) {
+        rows_.clear();
+        rowsWidth_ = width;
+        rowsComplete_ = false;
+    }
+    if (!rowsComplete_) {
+        rowsComplete_ = extendWrap(line, width, tabSize_, rows_, minRows, minByte);
+    }
+    return rows_;
+}
+
+} // namespace cvim
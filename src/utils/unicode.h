@@ -0,0 +1,116 @@
+#ifndef CVIM_UNICODE_H
+#define CVIM_UNICODE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace cvim {
+
+// Lines are UTF-8 bytes; columns in Position are byte offsets. These map
+// them to what the terminal shows. A character here is a grapheme cluster
+// as far as the screen is concerned: a base code point with the combining
+// marks, variation selectors and ZWJ-joined code points after it. Invalid
+// bytes count as one narrow character each.
+
+// Decode the code point at text[0], given length bytes are available;
+// returns the bytes it takes (at least 1). Invalid input gives U+FFFD.
+int decodeUtf8(const char* text, size_t length, uint32_t& codepoint);
+
+// Cells a code point takes on screen: 0, 1 or 2 (East Asian wide)
+int codepointWidth(uint32_t codepoint);
+
+// Character boundaries around byte pos
+size_t nextCharStart(const std::string& line, size_t pos);
+size_t prevCharStart(const std::string& line, size_t pos);
+// Start of the character that byte pos belongs to
+size_t charStart(const std::string& line, size_t pos);
+
+// Display column where byte pos starts, scanning from a known boundary;
+// tabs stop every tabSize columns
+int displayColumn(const std::string& line, size_t pos, int tabSize,
+                  size_t fromByte = 0, int fromColumn = 0);
+// Start byte of the character covering display column, or line.size()
+// past the end of the line
+size_t byteAtColumn(const std::string& line, int column, int tabSize,
+                    size_t fromByte = 0, int fromColumn = 0);
+
+// Append bytes [from, to) of the line as drawn, with each tab replaced by
+// spaces up to its tab stop; from is a character start at fromColumn
+void expandTabs(const std::string& line, size_t from, size_t to, int fromColumn,
+                int tabSize, std::string& out);
+
+// A character start and the display column it is drawn at
+struct ColumnMark {
+    uint32_t byte;
+    uint32_t column;
+};
+
+// byteAtColumn() together with the column that character is drawn at
+ColumnMark markAtColumn(const std::string& line, int column, int tabSize,
+                        size_t fromByte = 0, int fromColumn = 0);
+
+// Soft wrap: the start of each screen row when the line is wrapped at
+// width cells. A character that does not fit on the rest of a row (a wide
+// one, or a tab) starts the next row; every row holds at least one.
+void wrapLine(const std::string& line, int width, int tabSize, std::vector<ColumnMark>& rows);
+// wrapLine() picking up after the last row in rows, stopping once there are
+// minRows rows and the last starts at or past minByte. True at line end.
+bool extendWrap(const std::string& line, int width, int tabSize, std::vector<ColumnMark>& rows,
+                size_t minRows, size_t minByte);
+
+// Checkpoints every STEP bytes of a line, so both mappings on long lines
+// are a binary search and a scan of at most STEP bytes rather than a scan
+// from the start of the line. Built for one tabSize, and only as far along
+// the line as lookups have needed; the wrapped rows likewise, kept for the
+// last width asked for.
+//
+// An edit keeps what lies before it. Checkpoints past it are shifted into
+// a tail, and the scan takes them back once it meets one where the column
+// change cannot move a tab stop, so typing does not rescan the whole line.
+class ColumnIndex {
+public:
+    static const size_t STEP = 256;
+
+    explicit ColumnIndex(int tabSize);
+
+    int getColumn(const std::string& line, size_t pos) const;
+    size_t getByte(const std::string& line, int column) const;
+    ColumnMark getMark(const std::string& line, int column) const;
+    int getWidth(const std::string& line) const;
+    // At least minRows rows (fewer if the line runs out), up to one starting
+    // at or past minByte
+    const std::vector<ColumnMark>& getRows(const std::string& line, int width,
+                                           size_t minRows, size_t minByte) const;
+
+    // Bytes [byte, byte + removed) were replaced by inserted bytes; line is
+    // the text after the edit
+    void edit(const std::string& line, size_t byte, size_t removed, size_t inserted);
+
+private:
+    // Checkpoint until past untilByte and untilColumn, or the line end
+    void extend(const std::string& line, size_t untilByte, long untilColumn) const;
+    // Whether the tail can be taken back with its columns moved by delta
+    bool canJoin(const std::string& line, size_t byte, long delta) const;
+
+    int tabSize_;
+    mutable std::vector<ColumnMark> checkpoints_;
+    mutable bool complete_;  // checkpoints reach the line end
+    mutable int width_;      // valid when complete_
+    // Checkpoints from before the last edits, in the line's current bytes
+    // but with columns off by an unknown amount
+    mutable std::vector<ColumnMark> tail_;
+    bool tailComplete_;
+    int tailWidth_;
+    // Last tab in the line, or npos; worked out again when unknown
+    mutable size_t lastTab_;
+    mutable bool lastTabKnown_;
+    mutable std::vector<ColumnMark> rows_;
+    mutable int rowsWidth_;
+    mutable bool rowsComplete_;
+};
+
+} // namespace cvim
+
+#endif // CVIM_UNICODE_H